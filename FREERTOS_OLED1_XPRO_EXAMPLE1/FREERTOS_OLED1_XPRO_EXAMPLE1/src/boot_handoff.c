@@ -0,0 +1,182 @@
+/**
+ * \file
+ *
+ * \brief Verified boot handoff block left in RAM by the bootloader.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+#include <stddef.h>
+#include <string.h>
+#include "boot_handoff.h"
+
+#define SHA256_BLOCK_SIZE       64
+#define SHA256_DIGEST_SIZE      32
+
+typedef struct
+{
+	uint32_t state[8];
+	uint32_t length;
+	uint8_t block[SHA256_BLOCK_SIZE];
+	uint8_t used;
+} sha256_ctx;
+
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROR(x, n)   (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_compress(sha256_ctx *ctx)
+{
+	uint32_t w[64];
+	uint32_t s[8];
+	uint32_t t1, t2;
+	uint8_t i;
+
+	for (i = 0; i < 16; i++) {
+		w[i] = ((uint32_t)ctx->block[4 * i] << 24) | ((uint32_t)ctx->block[4 * i + 1] << 16) |
+				((uint32_t)ctx->block[4 * i + 2] << 8) | ctx->block[4 * i + 3];
+	}
+	for (i = 16; i < 64; i++) {
+		w[i] = w[i - 16] + (ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3)) +
+				w[i - 7] + (ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+	}
+
+	memcpy(s, ctx->state, sizeof(s));
+	for (i = 0; i < 64; i++) {
+		t1 = s[7] + (ROR(s[4], 6) ^ ROR(s[4], 11) ^ ROR(s[4], 25)) +
+				((s[4] & s[5]) ^ (~s[4] & s[6])) + sha256_k[i] + w[i];
+		t2 = (ROR(s[0], 2) ^ ROR(s[0], 13) ^ ROR(s[0], 22)) +
+				((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+		memmove(&s[1], &s[0], 7 * sizeof(s[0]));
+		s[4] += t1;
+		s[0] = t1 + t2;
+	}
+	for (i = 0; i < 8; i++) {
+		ctx->state[i] += s[i];
+	}
+}
+
+static void sha256_init(sha256_ctx *ctx)
+{
+	static const uint32_t sha256_h0[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+	};
+
+	memcpy(ctx->state, sha256_h0, sizeof(ctx->state));
+	ctx->length = 0;
+	ctx->used = 0;
+}
+
+static void sha256_update(sha256_ctx *ctx, const uint8_t *data, size_t length)
+{
+	while (length--) {
+		ctx->block[ctx->used++] = *data++;
+		ctx->length++;
+		if (ctx->used == SHA256_BLOCK_SIZE) {
+			sha256_compress(ctx);
+			ctx->used = 0;
+		}
+	}
+}
+
+static void sha256_finish(sha256_ctx *ctx, uint8_t *digest)
+{
+	uint32_t bits = ctx->length * 8;
+	uint8_t pad = 0x80;
+	uint8_t i;
+
+	sha256_update(ctx, &pad, 1);
+	pad = 0;
+	while (ctx->used != (SHA256_BLOCK_SIZE - 4)) {
+		sha256_update(ctx, &pad, 1);
+	}
+	for (i = 0; i < 4; i++) {
+		pad = (uint8_t)(bits >> (24 - 8 * i));
+		sha256_update(ctx, &pad, 1);
+	}
+	for (i = 0; i < 8; i++) {
+		digest[4 * i] = (uint8_t)(ctx->state[i] >> 24);
+		digest[4 * i + 1] = (uint8_t)(ctx->state[i] >> 16);
+		digest[4 * i + 2] = (uint8_t)(ctx->state[i] >> 8);
+		digest[4 * i + 3] = (uint8_t)ctx->state[i];
+	}
+}
+
+/**
+ * \brief HMAC-SHA256 with a BOOT_HANDOFF_KEY_SIZE byte key
+ */
+static void boot_handoff_hmac(const uint8_t *key, const uint8_t *data, size_t length, uint8_t *mac)
+{
+	sha256_ctx ctx;
+	uint8_t pad[SHA256_BLOCK_SIZE];
+	uint8_t inner[SHA256_DIGEST_SIZE];
+	uint8_t i;
+
+	memset(pad, 0x36, sizeof(pad));
+	for (i = 0; i < BOOT_HANDOFF_KEY_SIZE; i++) {
+		pad[i] ^= key[i];
+	}
+	sha256_init(&ctx);
+	sha256_update(&ctx, pad, sizeof(pad));
+	sha256_update(&ctx, data, length);
+	sha256_finish(&ctx, inner);
+
+	for (i = 0; i < sizeof(pad); i++) {
+		pad[i] ^= 0x36 ^ 0x5C;
+	}
+	sha256_init(&ctx);
+	sha256_update(&ctx, pad, sizeof(pad));
+	sha256_update(&ctx, inner, sizeof(inner));
+	sha256_finish(&ctx, mac);
+
+	memset(pad, 0, sizeof(pad));
+}
+
+const boot_handoff_block* boot_handoff_read(void)
+{
+	const boot_handoff_block *handoff = (const boot_handoff_block *)BOOT_HANDOFF_ADDRESS;
+	uint8_t mac[SHA256_DIGEST_SIZE];
+	uint8_t diff = 0;
+	uint8_t i;
+
+	if ((handoff->magic != BOOT_HANDOFF_MAGIC) || (handoff->version != BOOT_HANDOFF_VERSION)) {
+		return NULL;
+	}
+
+	boot_handoff_hmac((const uint8_t *)BOOT_HANDOFF_KEY_ADDRESS, (const uint8_t *)handoff,
+			offsetof(boot_handoff_block, mac), mac);
+	for (i = 0; i < sizeof(mac); i++) {
+		diff |= mac[i] ^ handoff->mac[i];
+	}
+
+	return (diff == 0) ? handoff : NULL;
+}
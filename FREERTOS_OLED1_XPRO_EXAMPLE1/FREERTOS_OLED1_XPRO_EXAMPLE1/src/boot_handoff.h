@@ -0,0 +1,73 @@
+/**
+ * \file
+ *
+ * \brief Verified boot handoff block left in RAM by the bootloader.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+#ifndef BOOT_HANDOFF_H
+#define BOOT_HANDOFF_H
+
+#include <stdint.h>
+
+/* Must match the bootloader's boot_handoff.h */
+#define BOOT_HANDOFF_ADDRESS        0x20007E00
+#define BOOT_HANDOFF_MAGIC          0x46444842
+#define BOOT_HANDOFF_VERSION        2
+/* IO protection key page of the bootloader, the MAC key */
+#define BOOT_HANDOFF_KEY_ADDRESS    0x00007FC0
+#define BOOT_HANDOFF_KEY_SIZE       32
+
+/** What the digest in the block is computed over */
+enum boot_handoff_digest_type
+{
+	BOOT_HANDOFF_DIGEST_SHA256 = 0,     /**< SHA-256 of the image */
+};
+
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint8_t  secure_boot_mode;          /**< SecureBoot command mode the image was verified with */
+	uint8_t  digest_type;               /**< enum boot_handoff_digest_type */
+	uint32_t boot_count;                /**< Verified boots since power-on */
+	uint32_t start_address;             /**< Image covered by the digest */
+	uint32_t memory_size;               /**< Signed length: the used image, the partitions and the footer without its signature */
+	uint32_t footer_version;
+	uint32_t verified_us;               /**< Microseconds from reset to the verification, 0 if not timed.
+	                                         A warm reset that skipped verification keeps the value */
+	uint8_t  digest[32];                /**< Digest the ATECC608A verified */
+	uint8_t  signature[64];             /**< Footer signature of the verified image */
+	uint8_t  mac[32];                   /**< HMAC-SHA256 with the IO protection key */
+} boot_handoff_block;
+
+/**
+ * \brief Result of the secure boot verification that started this image
+ *
+ * \return Pointer to the block, or NULL when the bootloader did not leave one
+ *         or its MAC does not match
+ */
+const boot_handoff_block* boot_handoff_read(void);
+
+#endif
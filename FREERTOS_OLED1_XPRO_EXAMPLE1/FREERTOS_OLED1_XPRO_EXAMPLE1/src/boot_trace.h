@@ -0,0 +1,98 @@
+/**
+ * \file
+ *
+ * \brief Read access to the boot phase trace left in RAM by the bootloader.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Must match the bootloader's boot_trace.h */
+#define BOOT_TRACE_ADDRESS      0x20007F00
+#define BOOT_TRACE_MAGIC        0x42545243
+#define BOOT_TRACE_ENTRIES      30
+
+/** Phase identifiers recorded by the bootloader */
+enum boot_trace_phase
+{
+	BOOT_TRACE_RESET                = 0,
+	BOOT_TRACE_SYSTEM_INIT_DONE     = 1,
+	BOOT_TRACE_RANDOM_SEED_DONE     = 2,
+	BOOT_TRACE_VERIFY_START         = 3,
+	BOOT_TRACE_PROBE_ADDRESS        = 4,
+	BOOT_TRACE_PROBE_DONE           = 5,
+	BOOT_TRACE_LOCK_CHECK_DONE      = 6,
+	BOOT_TRACE_MEMORY_INIT          = 7,
+	BOOT_TRACE_DIGEST_START         = 8,
+	BOOT_TRACE_DIGEST_DONE          = 9,
+	BOOT_TRACE_HOST_RANDOM          = 10,
+	BOOT_TRACE_FULL_COPY_MARKED     = 11,
+	BOOT_TRACE_MEMORY_DEINIT        = 12,
+	BOOT_TRACE_VERIFY_DONE          = 13,
+	BOOT_TRACE_JUMP_APPLICATION     = 14,
+	BOOT_TRACE_MONITOR_START        = 15,
+	BOOT_TRACE_HANDOFF_PUBLISHED    = 16,
+	BOOT_TRACE_WARM_RESUME          = 17,
+	BOOT_TRACE_CLOCK_BOOST          = 18,
+	BOOT_TRACE_CLOCK_RESTORE        = 19,
+	BOOT_TRACE_SLOT_SELECTED        = 20,
+};
+
+typedef struct
+{
+	uint32_t timestamp_us;
+	uint16_t phase;
+	uint16_t arg;
+} boot_trace_entry;
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t boot_count;
+	uint16_t head;
+	uint16_t count;
+	uint32_t reserved;
+	boot_trace_entry entries[BOOT_TRACE_ENTRIES];
+} boot_trace_buffer;
+
+/**
+ * \brief Trace recorded by the bootloader for this boot
+ *
+ * \return Pointer to the trace, or NULL when the bootloader did not leave one
+ */
+static inline const boot_trace_buffer* boot_trace_read(void)
+{
+	const boot_trace_buffer *trace = (const boot_trace_buffer *)BOOT_TRACE_ADDRESS;
+
+	if (trace->magic != BOOT_TRACE_MAGIC) {
+		return NULL;
+	}
+	return trace;
+}
+
+#endif
@@ -28,6 +28,8 @@
 
 #include <asf.h>
 #include "demotasks.h"
+#include "boot_trace.h"
+#include "boot_handoff.h"
 
 #define APP_START_ADDRESS					0x00008000
 #define USER_APPLICATION_START_PAGE			(APP_START_ADDRESS / NVMCTRL_PAGE_SIZE)
@@ -45,18 +47,34 @@ typedef struct
 	uint8_t reserved[52];				//Reserving 20-bytes for Application information
 }memory_parameters;
 
-/*Blocking last USER_APPLICATION_HEADER_SIZE bytes for Signature and memory/application specific information*/
+/*Slot the image is linked for and used image length, set by the linker
+ *script. Link with samd21j18a_flash_slot_b.ld to run from the second slot*/
+extern uint32_t _image_start;
+extern uint32_t _image_size;
+
+/*Blocking last USER_APPLICATION_HEADER_SIZE bytes for Signature and memory/application specific information.
+ *memory_size is the used image length plus the footer, the signature covers only those*/
 __attribute__ ((section(".footer_data")))
 const memory_parameters user_application_footer = 
 {
-	USER_APPLICATION_START_ADDRESS,
-	(USER_APPLICATION_END_ADDRESS - USER_APPLICATION_START_ADDRESS),
+	(uint32_t)&_image_start,
+	((uint32_t)&_image_size + USER_APPLICATION_HEADER_SIZE),
 	0x00010001,
 	{0},
 };
 
+/*Boot phase timing left by the bootloader, NULL if none was recorded*/
+const boot_trace_buffer* volatile bootloader_trace;
+
+/*Image digest and secure boot result published by the bootloader, NULL if
+ *it did not verify this boot. Attestation uses it instead of hashing the image*/
+const boot_handoff_block* volatile bootloader_handoff;
+
 int main (void)
 {
+	bootloader_trace = boot_trace_read();
+	bootloader_handoff = boot_handoff_read();
+
 	system_init();
 	gfx_mono_init();
 
@@ -25,12 +25,52 @@ BLOCKSIZE = 65536
 SIGNATURE_SIZE = 64
 APPLICATION_END_ADDRESS = 0x6000
 SIGANATURE_ADDRESS = APPLICATION_END_ADDRESS - SIGNATURE_SIZE
+# Footer (memory_parameters) is the last 128 bytes, the partition descriptor
+# goes into its reserved field after start_address, memory_size and version_info.
+# Offsets are from the start of the slot, start_address says which slot the
+# image is linked for
+FOOTER_ADDRESS = APPLICATION_END_ADDRESS - 128
+MEMORY_SIZE_ADDRESS = FOOTER_ADDRESS + 4
+DESCRIPTOR_ADDRESS = FOOTER_ADDRESS + 12
+# memory_size in the footer is the used image length plus the footer, set
+# by the linker script. Only the image length and the footer are signed
+# Partitions signed with the image, listed in the footer's reserved field
+# (see secure_boot_partition.c): row aligned, ascending, in flash above the
+# second application slot
+PARTITION_MAX = 5
+PARTITION_START_ADDRESS = 0x16000
+PARTITION_END_ADDRESS = 0x40000
+ROW_SIZE = 256
 
 # Setup cryptography
 crypto_be = cryptography.hazmat.backends.default_backend()
 
 
-def digest_sign(key_file,bin_file):
+def image_length(signing_file):
+	# Length recorded by the linker script. The used length cannot be told
+	# from the binary, trailing zero or 0xFF bytes may be part of the image
+	signing_file.seek(MEMORY_SIZE_ADDRESS)
+	memory_size = int.from_bytes(signing_file.read(4), 'little')
+	if (memory_size < 128) or (memory_size - 128 > FOOTER_ADDRESS):
+		raise ValueError('footer memory_size 0x%X is not a valid image length, link the image with the footer' % memory_size)
+	return memory_size - 128
+
+
+def partition_descriptor(partitions):
+	# "PART", the region count and address/length of each region
+	if len(partitions) > PARTITION_MAX:
+		raise ValueError('at most %d partitions' % PARTITION_MAX)
+	descriptor = b'PART' + bytes([len(partitions)]) + b'\xFF\xFF\xFF'
+	next_address = PARTITION_START_ADDRESS
+	for address, data in partitions:
+		if (address < next_address) or (address % ROW_SIZE) or (len(data) == 0) or (address + len(data) > PARTITION_END_ADDRESS):
+			raise ValueError('partition at 0x%X is not row aligned, in order or inside flash' % address)
+		next_address = address + len(data)
+		descriptor += address.to_bytes(4, 'little') + len(data).to_bytes(4, 'little')
+	return descriptor
+
+
+def digest_sign(key_file,bin_file,partitions=[]):
 	with open(key_file, 'rb') as f:
 	    # Loading the private key from key_file
 		private_key = serialization.load_pem_private_key(
@@ -43,10 +83,20 @@ def digest_sign(key_file,bin_file):
 	hasher = hashes.Hash(chosen_hash, crypto_be)
 	signing_file = open(bin_file, "rb+")
 	signing_file.truncate(SIGANATURE_ADDRESS)
-	buf = signing_file.read(BLOCKSIZE)
-	while len(buf) > 0:
-		hasher.update(buf)
-		buf = signing_file.read(BLOCKSIZE)
+	length = image_length(signing_file)
+	if partitions:
+		signing_file.seek(DESCRIPTOR_ADDRESS)
+		signing_file.write(partition_descriptor(partitions))
+
+	# Signed data: the used image, the partitions and the footer up to the signature
+	signing_file.seek(0)
+	signed_data = signing_file.read(length)
+	for address, data in partitions:
+		signed_data += data
+	signing_file.seek(FOOTER_ADDRESS)
+	signed_data += signing_file.read(SIGANATURE_ADDRESS - FOOTER_ADDRESS)
+	for offset in range(0, len(signed_data), BLOCKSIZE):
+		hasher.update(signed_data[offset:offset+BLOCKSIZE])
 	digest = hasher.finalize()
 
 	# Signing the digest of the Application binary file bin_file
@@ -76,9 +126,17 @@ if __name__ == "__main__":
 generates a key pair and uses it for Sign operation",
 		formatter_class=argparse.RawDescriptionHelpFormatter)
 	parser.add_argument('-k', '--key', help='Key to Sign the application')
+	parser.add_argument('-p', '--partition', action='append', default=[], metavar='ADDRESS:FILE',
+		help='Sign the contents of FILE, programmed at ADDRESS, with the application (repeatable)')
 	parser.add_argument("bin", help='User application file to Sign')
 	args = parser.parse_args()
 
+	partitions = []
+	for partition in args.partition:
+		address, partition_file = partition.split(':', 1)
+		with open(partition_file, 'rb') as f:
+			partitions.append((int(address, 0), f.read()))
+
 	key_file = args.key
 	bin_file = args.bin
 
@@ -98,5 +156,5 @@ generates a key pair and uses it for Sign operation",
 	if not bin_file:
 		print ('Application binary file is missing... Exiting now')
 		sys.exit(2)
-	digest_sign(key_file, bin_file)
+	digest_sign(key_file, bin_file, partitions)
 
@@ -0,0 +1,160 @@
+/**
+ * \file
+ *
+ * \brief Core clock profile of the verification phase.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <asf.h>
+#include "conf_clocks.h"
+#include "boot_clock.h"
+#include "boot_trace.h"
+
+/*
+ * Hashing the application is bound by the core clock, so the verification
+ * runs with GCLK0 on the DFLL at 48 MHz instead of OSC8M. The DFLL must be
+ * in open loop (running from its factory calibration) or off; a DFLL in
+ * closed loop or USB clock recovery belongs to somebody else and the core
+ * stays on OSC8M. Everything timed from GCLK0 (delays, the I2C baud rate,
+ * the pipelined digest clock) reads the rate when it starts, the boot trace
+ * is told about both changes. The application is entered with GCLK0 and the
+ * flash wait states as they were configured.
+ */
+
+#if BOOT_CLOCK_BOOST_ENABLED
+/** GCLK0 runs from the DFLL */
+static bool boot_clock_boosted;
+/** The DFLL was started for the boost and is stopped again */
+static bool boot_clock_dfll_started;
+/** Flash wait states before the boost */
+static uint8_t boot_clock_wait_states;
+
+/**
+ * \brief Start the DFLL in open loop from the factory coarse calibration
+ */
+static bool boot_clock_start_dfll(void)
+{
+	struct system_clock_source_dfll_config dfll_conf;
+	uint32_t coarse;
+
+	/* DFLL48M coarse calibration, bits 58 to 63 of the software calibration area */
+	coarse = (*((uint32_t *)NVMCTRL_OTP4 + 1) >> 26) & 0x3F;
+	if (coarse == 0x3F) {
+		coarse = 0x1F;
+	}
+
+	system_clock_source_dfll_get_config_defaults(&dfll_conf);
+	dfll_conf.loop_mode = SYSTEM_CLOCK_DFLL_LOOP_MODE_OPEN;
+	dfll_conf.on_demand = false;
+	dfll_conf.coarse_value = coarse;
+	dfll_conf.fine_value = CONF_CLOCK_DFLL_FINE_VALUE;
+	system_clock_source_dfll_set_config(&dfll_conf);
+
+	if (system_clock_source_enable(SYSTEM_CLOCK_SOURCE_DFLL) != STATUS_OK) {
+		return false;
+	}
+	while (!system_clock_source_is_ready(SYSTEM_CLOCK_SOURCE_DFLL)) {
+		/* Wait for the DFLL */
+	}
+
+	return true;
+}
+#endif
+
+/**
+ * \brief Switch the core to the DFLL for the verification
+ *
+ * The flash wait states are raised before the clock, nothing changes if the
+ * DFLL cannot be used.
+ */
+void boot_clock_boost(void)
+{
+#if BOOT_CLOCK_BOOST_ENABLED
+	struct system_gclk_gen_config gclk_conf;
+	uint32_t dfll_hz;
+
+	if (boot_clock_boosted) {
+		return;
+	}
+
+	dfll_hz = system_clock_source_get_hz(SYSTEM_CLOCK_SOURCE_DFLL);
+	if (dfll_hz == 0) {
+		boot_clock_dfll_started = boot_clock_start_dfll();
+		dfll_hz = system_clock_source_get_hz(SYSTEM_CLOCK_SOURCE_DFLL);
+	}
+	if (dfll_hz != BOOT_CLOCK_BOOST_HZ) {
+		/* Closed loop or not running, the core stays on its source */
+		BOOT_TRACE(BOOT_TRACE_CLOCK_BOOST, 0);
+		return;
+	}
+
+	boot_clock_wait_states = NVMCTRL->CTRLB.bit.RWS;
+	if (boot_clock_wait_states < BOOT_CLOCK_BOOST_WAIT_STATES) {
+		system_flash_set_waitstates(BOOT_CLOCK_BOOST_WAIT_STATES);
+	}
+
+	system_gclk_gen_get_config_defaults(&gclk_conf);
+	gclk_conf.source_clock = SYSTEM_CLOCK_SOURCE_DFLL;
+	gclk_conf.division_factor = 1;
+	system_gclk_gen_set_config(GCLK_GENERATOR_0, &gclk_conf);
+	boot_clock_boosted = true;
+
+	BOOT_TRACE_SET_CPU_HZ(system_cpu_clock_get_hz());
+	BOOT_TRACE(BOOT_TRACE_CLOCK_BOOST, system_cpu_clock_get_hz() / 1000000UL);
+#endif
+}
+
+/**
+ * \brief Put GCLK0 and the flash wait states back to the configured clock tree
+ *
+ * Called before the jump to the application and before the monitor starts.
+ */
+void boot_clock_restore(void)
+{
+#if BOOT_CLOCK_BOOST_ENABLED
+	struct system_gclk_gen_config gclk_conf;
+
+	if (!boot_clock_boosted) {
+		return;
+	}
+
+	system_gclk_gen_get_config_defaults(&gclk_conf);
+	gclk_conf.source_clock = CONF_CLOCK_GCLK_0_CLOCK_SOURCE;
+	gclk_conf.division_factor = CONF_CLOCK_GCLK_0_PRESCALER;
+	gclk_conf.run_in_standby = CONF_CLOCK_GCLK_0_RUN_IN_STANDBY;
+	system_gclk_gen_set_config(GCLK_GENERATOR_0, &gclk_conf);
+	boot_clock_boosted = false;
+
+	/* Only lowered once the core is slow again */
+	system_flash_set_waitstates(boot_clock_wait_states);
+	if (boot_clock_dfll_started) {
+		system_clock_source_disable(SYSTEM_CLOCK_SOURCE_DFLL);
+		boot_clock_dfll_started = false;
+	}
+
+	BOOT_TRACE_SET_CPU_HZ(system_cpu_clock_get_hz());
+	BOOT_TRACE(BOOT_TRACE_CLOCK_RESTORE, system_cpu_clock_get_hz() / 1000000UL);
+#endif
+}
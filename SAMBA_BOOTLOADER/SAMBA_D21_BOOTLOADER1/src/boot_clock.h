@@ -0,0 +1,58 @@
+/**
+ * \file
+ *
+ * \brief Core clock profile of the verification phase.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef BOOT_CLOCK_H
+#define BOOT_CLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/** Run the verification from the 48 MHz DFLL instead of OSC8M. The
+ *  configured clock tree is back before the application or the monitor
+ *  starts. */
+#ifndef BOOT_CLOCK_BOOST_ENABLED
+#define BOOT_CLOCK_BOOST_ENABLED        true
+#endif
+
+/** Core clock of the verification phase, the DFLL in open loop */
+#define BOOT_CLOCK_BOOST_HZ             48000000UL
+/** Flash wait states the core clock needs above 24 MHz at 3.3 V */
+#define BOOT_CLOCK_BOOST_WAIT_STATES    1
+
+void boot_clock_boost(void);
+void boot_clock_restore(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
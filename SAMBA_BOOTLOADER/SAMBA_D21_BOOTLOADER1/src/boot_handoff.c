@@ -0,0 +1,205 @@
+/**
+ * \file
+ *
+ * \brief Verified boot handoff block passed to the application in RAM.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+#include <stddef.h>
+#include <string.h>
+#include <asf.h>
+#include "io_protection_key.h"
+#include "secure_boot_hmac.h"
+#include "secure_boot_partition.h"
+#include "secure_boot_slot.h"
+#include "memory_conf.h"
+#include "boot_handoff.h"
+#include "boot_trace.h"
+
+/** Handoff block, in the RAM region the startup code of neither the
+ *  bootloader nor the application touches */
+static boot_handoff_block boot_handoff __attribute__((section(".noinit.boot_handoff"), used));
+
+/**
+ * \brief MAC of the block with the IO protection key, fails while the key is
+ *        not bound (all 0xFF)
+ */
+static ATCA_STATUS boot_handoff_mac(uint8_t *mac)
+{
+	ATCA_STATUS status;
+	uint8_t io_key[ATCA_KEY_SIZE];
+	secure_boot_hmac_ctx hmac;
+	uint8_t unbound = 0xFF;
+	uint8_t i;
+
+	do {
+		if ((status = io_protection_get_key(io_key)) != ATCA_SUCCESS) {
+			break;
+		}
+		for (i = 0; i < sizeof(io_key); i++) {
+			unbound &= io_key[i];
+		}
+		if (unbound == 0xFF) {
+			status = ATCA_GEN_FAIL;
+			break;
+		}
+
+		secure_boot_hmac_init(&hmac, io_key);
+		secure_boot_hmac_update(&hmac, &boot_handoff, offsetof(boot_handoff_block, mac));
+		secure_boot_hmac_finish(&hmac, mac);
+	} while (0);
+
+	memset(io_key, 0, sizeof(io_key));
+
+	return status;
+}
+
+/**
+ * \brief Invalidate the block of the previous boot, called first thing after
+ *        reset so that the application never sees a stale one. A valid block
+ *        is only suspended, boot_handoff_resume() may take it over. The boot
+ *        counter is kept across warm resets.
+ */
+void boot_handoff_begin(void)
+{
+	if (boot_handoff.magic == BOOT_HANDOFF_MAGIC) {
+		boot_handoff.magic = BOOT_HANDOFF_SUSPENDED;
+		return;
+	}
+	if ((boot_handoff.magic != BOOT_HANDOFF_PENDING) && (boot_handoff.magic != BOOT_HANDOFF_SUSPENDED)) {
+		boot_handoff.boot_count = 0;
+	}
+	boot_handoff.magic = BOOT_HANDOFF_PENDING;
+}
+
+/**
+ * \brief Take over the block of the previous boot instead of verifying again
+ *
+ * Only for a warm reset, the caller checks the reset cause. The block must
+ * have been valid at reset, its MAC must match and the footer in flash must
+ * be the one it was published for. On success the block is valid again for
+ * the application with the boot counter advanced, otherwise it stays invalid.
+ *
+ * \return ATCA_SUCCESS if the application can be started without verification
+ */
+ATCA_STATUS boot_handoff_resume(void)
+{
+	ATCA_STATUS status = ATCA_GEN_FAIL;
+#if BOOT_HANDOFF_WARM_RESET_ENABLED
+	memory_parameters footer;
+	const secure_boot_partition_region *regions;
+	uint8_t region_count;
+	uint32_t partition_length;
+	uint8_t mac[SECURE_BOOT_HMAC_SIZE];
+	uint8_t diff = 0;
+	uint8_t i;
+
+	do {
+		if ((boot_handoff.magic != BOOT_HANDOFF_SUSPENDED) || (boot_handoff.version != BOOT_HANDOFF_VERSION)) {
+			break;
+		}
+
+		boot_handoff.magic = BOOT_HANDOFF_MAGIC;
+		if ((status = boot_handoff_mac(mac)) != ATCA_SUCCESS) {
+			break;
+		}
+		for (i = 0; i < sizeof(mac); i++) {
+			diff |= mac[i] ^ boot_handoff.mac[i];
+		}
+		if (diff != 0) {
+			status = ATCA_CHECKMAC_VERIFY_FAILED;
+			break;
+		}
+
+		/* Resume the slot the block was published for, a new image in it
+		 * carries a new footer signature */
+		if (!secure_boot_slot_select_address(boot_handoff.start_address)) {
+			status = ATCA_GEN_FAIL;
+			break;
+		}
+		if (nvm_read_buffer(secure_boot_slot_header_address(), (uint8_t *)&footer, sizeof(footer)) != STATUS_OK) {
+			status = ATCA_GEN_FAIL;
+			break;
+		}
+		if ((status = secure_boot_partition_get(&footer, &regions, &region_count, &partition_length)) != ATCA_SUCCESS) {
+			break;
+		}
+		if ((footer.start_address != boot_handoff.start_address) ||
+				((footer.memory_size - sizeof(footer.signature) + partition_length) != boot_handoff.memory_size) ||
+				(footer.version_info != boot_handoff.footer_version) ||
+				(memcmp(footer.signature, boot_handoff.signature, sizeof(footer.signature)) != 0)) {
+			status = ATCA_GEN_FAIL;
+			break;
+		}
+
+		boot_handoff.boot_count++;
+		status = boot_handoff_mac(boot_handoff.mac);
+	} while (0);
+
+#endif
+	if (status != ATCA_SUCCESS) {
+		boot_handoff.magic = BOOT_HANDOFF_PENDING;
+	}
+	BOOT_TRACE(BOOT_TRACE_WARM_RESUME, status);
+
+	return status;
+}
+
+/**
+ * \brief Publish the result of a successful verification for the application
+ *
+ * The block is MACed with the IO protection key, nothing is published while
+ * the key is not bound (all 0xFF). The application is not affected by a
+ * failure, it just has to verify itself.
+ *
+ * \param[in] secure_boot_mode  SecureBoot command mode used
+ * \param[in] memory_params     Footer of the verified image
+ * \param[in] digest_type       What digest is computed over
+ * \param[in] digest            Digest the device verified
+ * \return ATCA_STATUS
+ */
+ATCA_STATUS boot_handoff_publish(uint8_t secure_boot_mode, const memory_parameters* memory_params,
+		boot_handoff_digest_type digest_type, const uint8_t* digest)
+{
+	ATCA_STATUS status;
+
+	boot_handoff.magic = BOOT_HANDOFF_MAGIC;
+	boot_handoff.version = BOOT_HANDOFF_VERSION;
+	boot_handoff.secure_boot_mode = secure_boot_mode;
+	boot_handoff.digest_type = (uint8_t)digest_type;
+	boot_handoff.boot_count++;
+	boot_handoff.start_address = memory_params->start_address;
+	boot_handoff.memory_size = memory_params->memory_size;
+	boot_handoff.footer_version = memory_params->version_info;
+	boot_handoff.verified_us = BOOT_TRACE_NOW_US();
+	memcpy(boot_handoff.digest, digest, sizeof(boot_handoff.digest));
+	memcpy(boot_handoff.signature, memory_params->signature, sizeof(boot_handoff.signature));
+
+	if ((status = boot_handoff_mac(boot_handoff.mac)) != ATCA_SUCCESS) {
+		boot_handoff.magic = BOOT_HANDOFF_PENDING;
+	}
+	BOOT_TRACE(BOOT_TRACE_HANDOFF_PUBLISHED, status);
+
+	return status;
+}
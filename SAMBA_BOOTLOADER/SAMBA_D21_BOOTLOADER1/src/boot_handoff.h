@@ -0,0 +1,93 @@
+/**
+ * \file
+ *
+ * \brief Verified boot handoff block passed to the application in RAM.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef BOOT_HANDOFF_H
+#define BOOT_HANDOFF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "atca_status.h"
+#include "secure_boot.h"
+
+/** Handoff block lives in the .noinit RAM below the boot trace; the
+ *  application reads it at this address */
+#define BOOT_HANDOFF_ADDRESS        0x20007E00
+#define BOOT_HANDOFF_MAGIC          0x46444842      /* "BHDF" */
+/** Set from reset until the image is verified, the block is not valid */
+#define BOOT_HANDOFF_PENDING        0x50444842      /* "BHDP" */
+/** Valid block of the previous boot, until boot_handoff_resume() decides */
+#define BOOT_HANDOFF_SUSPENDED      0x53444842      /* "BHDS" */
+#define BOOT_HANDOFF_VERSION        2
+
+/** Jump straight to the application after a watchdog or software reset if
+ *  the block of the previous boot is intact and the footer in flash is the
+ *  one it was published for. The image itself is not hashed again, so this
+ *  trusts that nothing wrote the application region since then without
+ *  also changing its footer. */
+#ifndef BOOT_HANDOFF_WARM_RESET_ENABLED
+#define BOOT_HANDOFF_WARM_RESET_ENABLED     false
+#endif
+
+/** \brief What the digest in the block is computed over */
+typedef enum
+{
+    BOOT_HANDOFF_DIGEST_SHA256 = 0      /**< SHA-256 of the image */
+} boot_handoff_digest_type;
+
+/** \brief Result of the verification this boot, authenticated with the IO
+ *         protection key. The layout is shared with the application. */
+typedef struct
+{
+    uint32_t magic;                 /**< BOOT_HANDOFF_MAGIC once published */
+    uint16_t version;               /**< BOOT_HANDOFF_VERSION */
+    uint8_t  secure_boot_mode;      /**< SecureBoot command mode the image was verified with */
+    uint8_t  digest_type;           /**< boot_handoff_digest_type */
+    uint32_t boot_count;            /**< Verified boots since power-on, survives warm resets */
+    uint32_t start_address;         /**< Image covered by the digest, from its footer */
+    uint32_t memory_size;           /**< Signed length: the used image, the partitions and the footer without its signature */
+    uint32_t footer_version;        /**< Footer version_info */
+    uint32_t verified_us;           /**< Microseconds from reset to the verification result, 0 without the boot trace */
+    uint8_t  digest[ATCA_SHA_DIGEST_SIZE];  /**< Digest the device verified */
+    uint8_t  signature[ATCA_SIG_SIZE];      /**< Footer signature of the verified image */
+    uint8_t  mac[ATCA_SHA_DIGEST_SIZE];     /**< HMAC-SHA256 over the fields above */
+} boot_handoff_block;
+
+void boot_handoff_begin(void);
+ATCA_STATUS boot_handoff_resume(void);
+ATCA_STATUS boot_handoff_publish(uint8_t secure_boot_mode, const memory_parameters* memory_params,
+                                 boot_handoff_digest_type digest_type, const uint8_t* digest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,417 @@
+/**
+ * \file
+ *
+ * \brief Append-only journal of the bootloader state in a pair of flash rows.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <string.h>
+#include <asf.h>
+#include "memory_conf.h"
+#include "boot_journal.h"
+
+/*
+ * State the bootloader changes at run time (update marker, device cache,
+ * boot count, DRBG count) is appended as records to one of two
+ * flash rows instead of rewriting a page or a whole row per change. Records
+ * are 16 byte aligned and never cross a page; appending one programs its
+ * page again with 0xFF around it, which leaves the records already there as
+ * they are. The newest record of each type wins, by sequence number, across
+ * both rows.
+ *
+ * When the row appended to is full, the other row is erased and the newest
+ * record of each type is copied into it, so a row is erased once every few
+ * dozen changes. A copy cut short by a reset leaves some types only in the
+ * old row; they are copied over on the next load, before the old row can be
+ * erased again. A torn record fails its check and the rest of its page is
+ * skipped.
+ */
+
+/** Record alignment */
+#define BOOT_JOURNAL_UNIT                   16
+/** Largest payload, a record does not cross a flash page */
+#define BOOT_JOURNAL_PAYLOAD_MAX            (NVMCTRL_PAGE_SIZE - sizeof(boot_journal_header))
+/** Type of an erased record */
+#define BOOT_JOURNAL_ERASED                 0xFF
+
+static bool boot_journal_loaded;
+/** Row records are appended to */
+static uint8_t boot_journal_row;
+/** First free address in that row */
+static uint32_t boot_journal_next;
+/** Sequence number of the newest record */
+static uint16_t boot_journal_sequence;
+/** Address of the newest record of each type, 0 if there is none */
+static uint32_t boot_journal_latest[BOOT_JOURNAL_TYPE_COUNT];
+
+#if BOOT_JOURNAL_ROW_COUNT != 2
+#error "The journal alternates between two rows"
+#endif
+
+/** \brief Returns the start address of a journal row */
+static uint32_t boot_journal_row_address(uint8_t row)
+{
+	return BOOT_JOURNAL_ADDRESS + ((uint32_t)row * NVMCTRL_ROW_SIZE);
+}
+
+/** \brief Returns the record at a flash address, in memory mapped flash */
+static const boot_journal_header* boot_journal_at(uint32_t address)
+{
+	return (const boot_journal_header*)(FLASH_ADDR + address);
+}
+
+/** \brief Returns the flash bytes a record with this payload takes */
+static uint32_t boot_journal_size(uint8_t length)
+{
+	return (sizeof(boot_journal_header) + length + BOOT_JOURNAL_UNIT - 1) & ~(BOOT_JOURNAL_UNIT - 1);
+}
+
+/** \brief true if sequence a was written after sequence b */
+static bool boot_journal_newer(uint16_t a, uint16_t b)
+{
+	return ((int16_t)(a - b) > 0);
+}
+
+/** \brief Check value of a record, FNV-1a over the header fields and the
+ *         payload that follows the header
+ */
+static uint32_t boot_journal_check(const boot_journal_header* header)
+{
+	const uint8_t* payload = (const uint8_t*)(header + 1);
+	uint8_t fields[4] = {header->type, header->length, (uint8_t)header->sequence, (uint8_t)(header->sequence >> 8)};
+	uint32_t hash = 0x811C9DC5UL;
+	uint8_t i;
+
+	for(i = 0; i < sizeof(fields); i++)
+	{
+		hash = (hash ^ fields[i]) * 0x01000193UL;
+	}
+	for(i = 0; i < header->length; i++)
+	{
+		hash = (hash ^ payload[i]) * 0x01000193UL;
+	}
+
+	return hash;
+}
+
+/** \brief Checks that a unit of flash is erased */
+static bool boot_journal_is_erased(uint32_t address)
+{
+	const uint32_t* words = (const uint32_t*)(FLASH_ADDR + address);
+	uint8_t i;
+
+	for(i = 0; i < (BOOT_JOURNAL_UNIT / sizeof(uint32_t)); i++)
+	{
+		if(words[i] != 0xFFFFFFFFUL)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** \brief Indexes the valid records of a row
+ *	\param[in] uint8_t row Journal row
+ *	\param[out] bool* has_records Set if the row holds a valid record
+ *	\param[out] uint16_t* newest Sequence number of its newest record
+ *	\return First free address in the row
+ */
+static uint32_t boot_journal_scan(uint8_t row, bool* has_records, uint16_t* newest)
+{
+	uint32_t address = boot_journal_row_address(row);
+	uint32_t end = address + NVMCTRL_ROW_SIZE;
+	uint32_t page_end;
+	const boot_journal_header* header;
+
+	*has_records = false;
+	while(address < end)
+	{
+		header = boot_journal_at(address);
+		page_end = (address | (NVMCTRL_PAGE_SIZE - 1)) + 1;
+
+		if(boot_journal_is_erased(address))
+		{
+			if((address & (NVMCTRL_PAGE_SIZE - 1)) == 0)
+			{
+				/* Nothing was appended after this page */
+				break;
+			}
+			/* The next record did not fit in this page */
+			address = page_end;
+			continue;
+		}
+
+		if((header->type >= BOOT_JOURNAL_TYPE_COUNT) || (header->length > BOOT_JOURNAL_PAYLOAD_MAX) ||
+		((address + boot_journal_size(header->length)) > page_end) || (header->check != boot_journal_check(header)))
+		{
+			/* Torn record, nothing else is written into this page */
+			address = page_end;
+			continue;
+		}
+
+		if((boot_journal_latest[header->type] == 0) ||
+		boot_journal_newer(header->sequence, boot_journal_at(boot_journal_latest[header->type])->sequence))
+		{
+			boot_journal_latest[header->type] = address;
+		}
+		if(!*has_records || boot_journal_newer(header->sequence, *newest))
+		{
+			*newest = header->sequence;
+		}
+		*has_records = true;
+		address += boot_journal_size(header->length);
+	}
+
+	return address;
+}
+
+/** \brief Returns where a record of size bytes goes in the current row
+ *	\return Address, 0 if the row is full
+ */
+static uint32_t boot_journal_reserve(uint32_t size)
+{
+	uint32_t address = boot_journal_next;
+
+	if(((address & (NVMCTRL_PAGE_SIZE - 1)) + size) > NVMCTRL_PAGE_SIZE)
+	{
+		address = (address | (NVMCTRL_PAGE_SIZE - 1)) + 1;
+	}
+	if((address + size) > (boot_journal_row_address(boot_journal_row) + NVMCTRL_ROW_SIZE))
+	{
+		return 0;
+	}
+
+	return address;
+}
+
+/** \brief Programs a record at an address returned by boot_journal_reserve()
+ *	\return ATCA_STATUS
+ */
+static ATCA_STATUS boot_journal_program(uint32_t address, uint8_t type, const uint8_t* payload, uint8_t length)
+{
+	uint32_t page[NVMCTRL_PAGE_SIZE / sizeof(uint32_t)];
+	boot_journal_header* header = (boot_journal_header*)((uint8_t*)page + (address & (NVMCTRL_PAGE_SIZE - 1)));
+	uint32_t size = boot_journal_size(length);
+
+	/* Bytes of the page outside the record stay 0xFF, programming them
+	 * leaves the records already there unchanged */
+	memset(page, 0xFF, sizeof(page));
+	header->type = type;
+	header->length = length;
+	header->sequence = boot_journal_sequence + 1;
+	memcpy(header + 1, payload, length);
+	header->check = boot_journal_check(header);
+
+	boot_journal_next = address + size;
+	if((nvm_write_buffer(address & ~(NVMCTRL_PAGE_SIZE - 1), (uint8_t*)page, NVMCTRL_PAGE_SIZE) != STATUS_OK) ||
+	(memcmp(boot_journal_at(address), header, sizeof(*header) + length) != 0))
+	{
+		/* Leave the page alone from now on */
+		boot_journal_next = (address | (NVMCTRL_PAGE_SIZE - 1)) + 1;
+		return ATCA_GEN_FAIL;
+	}
+
+	boot_journal_sequence++;
+	boot_journal_latest[type] = address;
+
+	return ATCA_SUCCESS;
+}
+
+/** \brief Erases the other row and copies the newest record of each type
+ *         into it, appending continues there
+ *	\return ATCA_STATUS
+ */
+static ATCA_STATUS boot_journal_compact(void)
+{
+	const boot_journal_header* header;
+	uint32_t address;
+	uint8_t type;
+
+	boot_journal_row ^= 1;
+	boot_journal_next = boot_journal_row_address(boot_journal_row);
+	if(nvm_erase_row(boot_journal_next) != STATUS_OK)
+	{
+		return ATCA_GEN_FAIL;
+	}
+
+	for(type = 0; type < BOOT_JOURNAL_TYPE_COUNT; type++)
+	{
+		if(boot_journal_latest[type] == 0)
+		{
+			continue;
+		}
+		header = boot_journal_at(boot_journal_latest[type]);
+		if(((address = boot_journal_reserve(boot_journal_size(header->length))) == 0) ||
+		(boot_journal_program(address, type, (const uint8_t*)(header + 1), header->length) != ATCA_SUCCESS))
+		{
+			return ATCA_GEN_FAIL;
+		}
+	}
+
+	return ATCA_SUCCESS;
+}
+
+/** \brief Appends a record, compacting the journal if the row is full
+ *	\return ATCA_STATUS
+ */
+static ATCA_STATUS boot_journal_append(uint8_t type, const uint8_t* payload, uint8_t length)
+{
+	uint32_t address;
+
+	if((address = boot_journal_reserve(boot_journal_size(length))) == 0)
+	{
+		if(boot_journal_compact() != ATCA_SUCCESS)
+		{
+			/* Index again from flash on the next call */
+			boot_journal_loaded = false;
+			return ATCA_GEN_FAIL;
+		}
+		if((address = boot_journal_reserve(boot_journal_size(length))) == 0)
+		{
+			return ATCA_GEN_FAIL;
+		}
+	}
+
+	return boot_journal_program(address, type, payload, length);
+}
+
+/** \brief Indexes both rows on first use and sets up the NVM controller */
+static void boot_journal_load(void)
+{
+	struct nvm_config config;
+	uint32_t next[2];
+	bool has_records[2];
+	uint16_t newest[2];
+	const boot_journal_header* header;
+	uint32_t address;
+	uint8_t type;
+
+	if(boot_journal_loaded)
+	{
+		return;
+	}
+
+	/* Keep the wait states of the current clock, automatic page writes */
+	nvm_get_config_defaults(&config);
+	config.manual_page_write = false;
+	nvm_set_config(&config);
+
+	memset(boot_journal_latest, 0, sizeof(boot_journal_latest));
+	next[0] = boot_journal_scan(0, &has_records[0], &newest[0]);
+	next[1] = boot_journal_scan(1, &has_records[1], &newest[1]);
+
+	boot_journal_row = (has_records[1] && (!has_records[0] || boot_journal_newer(newest[1], newest[0]))) ? 1 : 0;
+	boot_journal_next = next[boot_journal_row];
+	boot_journal_sequence = has_records[boot_journal_row] ? newest[boot_journal_row] : 0;
+	boot_journal_loaded = true;
+
+	/* Finish a compaction cut short, the other row is erased next. The
+	 * copy left room for the records it did not get to. */
+	for(type = 0; type < BOOT_JOURNAL_TYPE_COUNT; type++)
+	{
+		if((boot_journal_latest[type] != 0) &&
+		((boot_journal_latest[type] & ~(NVMCTRL_ROW_SIZE - 1)) != boot_journal_row_address(boot_journal_row)))
+		{
+			header = boot_journal_at(boot_journal_latest[type]);
+			if((address = boot_journal_reserve(boot_journal_size(header->length))) != 0)
+			{
+				boot_journal_program(address, type, (const uint8_t*)(header + 1), header->length);
+			}
+		}
+	}
+}
+
+/** \brief Reads the newest record of a type
+ *	\param[in] boot_journal_type type Record type
+ *	\param[out] void* data Payload
+ *	\param[in] uint8_t length Payload bytes expected
+ *	\return true if a record of that type and length was found
+ */
+bool boot_journal_read(boot_journal_type type, void* data, uint8_t length)
+{
+	const boot_journal_header* header;
+
+	if(type >= BOOT_JOURNAL_TYPE_COUNT)
+	{
+		return false;
+	}
+	boot_journal_load();
+	if(boot_journal_latest[type] == 0)
+	{
+		return false;
+	}
+
+	header = boot_journal_at(boot_journal_latest[type]);
+	if(header->length != length)
+	{
+		return false;
+	}
+	memcpy(data, header + 1, length);
+
+	return true;
+}
+
+/** \brief Appends a record of a type. Nothing is written if the newest
+ *         record already holds the same payload.
+ *	\param[in] boot_journal_type type Record type
+ *	\param[in] void* data Payload
+ *	\param[in] uint8_t length Payload bytes
+ *	\return ATCA_STATUS
+ */
+ATCA_STATUS boot_journal_write(boot_journal_type type, const void* data, uint8_t length)
+{
+	const boot_journal_header* header;
+
+	if((type >= BOOT_JOURNAL_TYPE_COUNT) || (length > BOOT_JOURNAL_PAYLOAD_MAX))
+	{
+		return ATCA_BAD_PARAM;
+	}
+	boot_journal_load();
+
+	if(boot_journal_latest[type] != 0)
+	{
+		header = boot_journal_at(boot_journal_latest[type]);
+		if((header->length == length) && (memcmp(header + 1, data, length) == 0))
+		{
+			return ATCA_SUCCESS;
+		}
+	}
+
+	return boot_journal_append(type, (const uint8_t*)data, length);
+}
+
+/** \brief Counts a verified boot
+ *	\return ATCA_STATUS
+ */
+ATCA_STATUS boot_journal_count_boot(void)
+{
+	uint32_t count = 0;
+
+	boot_journal_read(BOOT_JOURNAL_BOOT_COUNT, &count, sizeof(count));
+	count++;
+
+	return boot_journal_write(BOOT_JOURNAL_BOOT_COUNT, &count, sizeof(count));
+}
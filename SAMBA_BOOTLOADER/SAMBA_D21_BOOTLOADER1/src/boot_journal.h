@@ -0,0 +1,73 @@
+/**
+ * \file
+ *
+ * \brief Append-only journal of the bootloader state in a pair of flash rows.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef BOOT_JOURNAL_H
+#define BOOT_JOURNAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "atca_status.h"
+
+/** Count the verified boots in the journal, one record per boot */
+#ifndef BOOT_JOURNAL_BOOT_COUNT_ENABLED
+#define BOOT_JOURNAL_BOOT_COUNT_ENABLED     false
+#endif
+
+/** \brief Kinds of state kept in the journal, the newest record of each wins */
+typedef enum
+{
+	BOOT_JOURNAL_UPDATE_MARKER = 0,     /**< Image the device holds the digest of (FullDig) */
+	BOOT_JOURNAL_DEVICE_CACHE,          /**< crypto_device_cache_record */
+	BOOT_JOURNAL_BOOT_COUNT,            /**< Verified boots, uint32_t */
+	BOOT_JOURNAL_DRBG_COUNT,            /**< DRBG instantiations, uint32_t */
+	BOOT_JOURNAL_TYPE_COUNT
+} boot_journal_type;
+
+/** \brief Record header, the payload follows and the record is padded to 16 bytes */
+typedef struct
+{
+	uint8_t type;                       /**< boot_journal_type, 0xFF in erased flash */
+	uint8_t length;                     /**< Payload bytes */
+	uint16_t sequence;                  /**< One more than the record written before */
+	uint32_t check;                     /**< See boot_journal_check() */
+} boot_journal_header;
+
+bool boot_journal_read(boot_journal_type type, void* data, uint8_t length);
+ATCA_STATUS boot_journal_write(boot_journal_type type, const void* data, uint8_t length);
+ATCA_STATUS boot_journal_count_boot(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,209 @@
+/**
+ * \file
+ *
+ * \brief Boot phase timing trace kept in RAM across the jump to the application.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+#include "asf.h"
+#include "boot_trace.h"
+
+#if BOOT_TRACE_ENABLED
+
+/** SysTick reload value, the counter is 24 bits wide */
+#define BOOT_TRACE_SYSTICK_RELOAD       0x00FFFFFFUL
+/** Core clock once BOOT_TRACE_START() has selected the OSC8M /1 prescaler */
+#define BOOT_TRACE_DEFAULT_CPU_HZ       8000000UL
+
+/** Trace buffer, placed in a RAM region the startup code neither clears
+ *  nor initializes so that it survives the jump into the application */
+static boot_trace_buffer boot_trace __attribute__((section(".noinit.boot_trace"), used));
+
+static uint32_t boot_trace_cycles_per_us;
+static uint32_t boot_trace_elapsed_us;
+static uint32_t boot_trace_residual_cycles;
+static bool boot_trace_running;
+
+/**
+ * \brief Fold the given number of cycles into the microsecond counter
+ */
+static void boot_trace_fold(uint32_t cycles)
+{
+	cycles += boot_trace_residual_cycles;
+	boot_trace_elapsed_us += cycles / boot_trace_cycles_per_us;
+	boot_trace_residual_cycles = cycles % boot_trace_cycles_per_us;
+}
+
+/**
+ * \brief Cycles counted by SysTick since the last reload, including a wrap
+ *        that is pending but not yet handled. Call with interrupts disabled.
+ */
+static uint32_t boot_trace_pending_cycles(void)
+{
+	uint32_t cycles = BOOT_TRACE_SYSTICK_RELOAD - SysTick->VAL;
+
+	if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+		/* Counter wrapped, fold the full period and re-read */
+		SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+		boot_trace_fold(BOOT_TRACE_SYSTICK_RELOAD + 1);
+		cycles = BOOT_TRACE_SYSTICK_RELOAD - SysTick->VAL;
+	}
+
+	return cycles;
+}
+
+/**
+ * \brief Microseconds since BOOT_TRACE_RESET. Call with interrupts disabled.
+ */
+static uint32_t boot_trace_timestamp_us(void)
+{
+	return boot_trace_elapsed_us +
+			(boot_trace_pending_cycles() + boot_trace_residual_cycles) / boot_trace_cycles_per_us;
+}
+
+/**
+ * \brief SysTick is otherwise unused by the bootloader, each wrap is folded
+ *        into the microsecond counter.
+ */
+void SysTick_Handler(void)
+{
+	boot_trace_fold(BOOT_TRACE_SYSTICK_RELOAD + 1);
+}
+
+/**
+ * \brief Start the trace clock and open a new trace for this boot
+ *
+ * Selects the OSC8M /1 prescaler (as system_init() does later) so the core
+ * runs at a known rate from the first record on.
+ */
+void boot_trace_init(void)
+{
+	SYSCTRL->OSC8M.bit.PRESC = 0;
+
+	if (boot_trace.magic == BOOT_TRACE_MAGIC) {
+		boot_trace.boot_count++;
+	} else {
+		boot_trace.magic = BOOT_TRACE_MAGIC;
+		boot_trace.boot_count = 1;
+	}
+	boot_trace.head = 0;
+	boot_trace.count = 0;
+	boot_trace.reserved = 0;
+
+	boot_trace_cycles_per_us = BOOT_TRACE_DEFAULT_CPU_HZ / 1000000UL;
+	boot_trace_elapsed_us = 0;
+	boot_trace_residual_cycles = 0;
+
+	SysTick->LOAD = BOOT_TRACE_SYSTICK_RELOAD;
+	SysTick->VAL = 0;
+	SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk |
+			SysTick_CTRL_ENABLE_Msk;
+	boot_trace_running = true;
+
+	boot_trace_record(BOOT_TRACE_RESET, 0);
+}
+
+/**
+ * \brief Inform the trace clock of a core clock change. Cycles elapsed so far
+ *        are converted at the previous rate.
+ */
+void boot_trace_set_cpu_hz(uint32_t cpu_hz)
+{
+	if (!boot_trace_running || (cpu_hz < 1000000UL)) {
+		return;
+	}
+
+	system_interrupt_enter_critical_section();
+	boot_trace_fold(boot_trace_pending_cycles());
+	boot_trace_residual_cycles = 0;
+	boot_trace_cycles_per_us = cpu_hz / 1000000UL;
+	/* Clears the counter, next tick reloads it without an exception */
+	SysTick->VAL = 0;
+	system_interrupt_leave_critical_section();
+}
+
+/**
+ * \brief Stop the trace clock and release SysTick for the application
+ */
+void boot_trace_stop(void)
+{
+	SysTick->CTRL = 0;
+	SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+	boot_trace_running = false;
+}
+
+/**
+ * \brief Append a timestamped phase record, oldest entries are overwritten
+ */
+void boot_trace_record(boot_trace_phase phase, uint32_t arg)
+{
+	boot_trace_entry *entry;
+	uint32_t timestamp_us;
+
+	if (!boot_trace_running) {
+		return;
+	}
+
+	system_interrupt_enter_critical_section();
+	timestamp_us = boot_trace_timestamp_us();
+
+	entry = &boot_trace.entries[boot_trace.head];
+	entry->timestamp_us = timestamp_us;
+	entry->phase = (uint16_t)phase;
+	entry->arg = (uint16_t)arg;
+
+	boot_trace.head = (boot_trace.head + 1) % BOOT_TRACE_ENTRIES;
+	if (boot_trace.count < UINT16_MAX) {
+		boot_trace.count++;
+	}
+	system_interrupt_leave_critical_section();
+}
+
+/**
+ * \brief Microseconds since BOOT_TRACE_RESET, 0 once the trace clock is stopped
+ */
+uint32_t boot_trace_now_us(void)
+{
+	uint32_t timestamp_us;
+
+	if (!boot_trace_running) {
+		return 0;
+	}
+
+	system_interrupt_enter_critical_section();
+	timestamp_us = boot_trace_timestamp_us();
+	system_interrupt_leave_critical_section();
+
+	return timestamp_us;
+}
+
+/**
+ * \brief Trace of the current boot
+ */
+const boot_trace_buffer* boot_trace_get(void)
+{
+	return &boot_trace;
+}
+
+#endif
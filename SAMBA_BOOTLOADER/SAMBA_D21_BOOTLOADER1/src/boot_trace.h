@@ -0,0 +1,120 @@
+/**
+ * \file
+ *
+ * \brief Boot phase timing trace kept in RAM across the jump to the application.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/** \brief Phases recorded along the boot path. Values are part of the trace
+ *         format read by the SAM-BA 'P' command and by the application. */
+typedef enum
+{
+    BOOT_TRACE_RESET                = 0,    /**< main() entered, trace clock started */
+    BOOT_TRACE_SYSTEM_INIT_DONE     = 1,    /**< system_init() returned */
+    BOOT_TRACE_RANDOM_SEED_DONE     = 2,    /**< Host DRBG seeded from the device, arg is status */
+    BOOT_TRACE_VERIFY_START         = 3,    /**< crypto_device_verify_app() entered */
+    BOOT_TRACE_PROBE_ADDRESS        = 4,    /**< atcab_init() attempted, arg is I2C address */
+    BOOT_TRACE_PROBE_DONE           = 5,    /**< Device found, arg is I2C address */
+    BOOT_TRACE_LOCK_CHECK_DONE      = 6,    /**< Public key slot lock verified, arg is slot */
+    BOOT_TRACE_MEMORY_INIT          = 7,    /**< secure_boot_process() started memory setup */
+    BOOT_TRACE_DIGEST_START         = 8,    /**< Header validated, arg is image length */
+    BOOT_TRACE_DIGEST_DONE          = 9,    /**< Last image byte handed to the digest */
+    BOOT_TRACE_HOST_RANDOM          = 10,   /**< Host nonce generated for the MAC exchange */
+    BOOT_TRACE_FULL_COPY_MARKED     = 11,   /**< Update marker written after FullCopy */
+    BOOT_TRACE_MEMORY_DEINIT        = 12,   /**< secure_boot_process() finishing */
+    BOOT_TRACE_VERIFY_DONE          = 13,   /**< secure_boot_process() returned, arg is status */
+    BOOT_TRACE_JUMP_APPLICATION     = 14,   /**< Jumping to the application */
+    BOOT_TRACE_MONITOR_START        = 15,   /**< Staying in the SAM-BA monitor */
+    BOOT_TRACE_HANDOFF_PUBLISHED    = 16,   /**< Handoff block for the application written, arg is status */
+    BOOT_TRACE_WARM_RESUME          = 17,   /**< Handoff block of the previous boot checked on a warm reset, arg is status */
+    BOOT_TRACE_CLOCK_BOOST          = 18,   /**< Core clock raised for the verification, arg is MHz (0 if it stayed) */
+    BOOT_TRACE_CLOCK_RESTORE        = 19,   /**< Configured core clock back, arg is MHz */
+    BOOT_TRACE_SLOT_SELECTED        = 20,   /**< Application slot to verify, first choice or fallback, arg is the slot */
+    BOOT_TRACE_PHASE_COUNT
+} boot_trace_phase;
+
+#ifndef BOOT_TRACE_ENABLED
+#define BOOT_TRACE_ENABLED      true
+#endif
+
+/** Trace buffer lives in the last 256 bytes of SRAM; the bootloader and the
+ *  application linker scripts both keep this region out of .bss and stack */
+#define BOOT_TRACE_ADDRESS      0x20007F00
+#define BOOT_TRACE_MAGIC        0x42545243      /* "CRTB" */
+#define BOOT_TRACE_ENTRIES      30
+
+/** \brief One timestamped phase record */
+typedef struct
+{
+    uint32_t timestamp_us;      /**< Microseconds since BOOT_TRACE_RESET */
+    uint16_t phase;             /**< boot_trace_phase */
+    uint16_t arg;               /**< Phase specific argument, truncated to 16 bits */
+} boot_trace_entry;
+
+/** \brief Ring buffer kept in .noinit RAM across the jump to the application */
+typedef struct
+{
+    uint32_t magic;             /**< BOOT_TRACE_MAGIC when the content is valid */
+    uint32_t boot_count;        /**< Boots since power-on, survives warm resets */
+    uint16_t head;              /**< Index of the next entry to write */
+    uint16_t count;             /**< Entries recorded this boot, may exceed BOOT_TRACE_ENTRIES */
+    uint32_t reserved;
+    boot_trace_entry entries[BOOT_TRACE_ENTRIES];
+} boot_trace_buffer;
+
+#if BOOT_TRACE_ENABLED
+void boot_trace_init(void);
+void boot_trace_set_cpu_hz(uint32_t cpu_hz);
+void boot_trace_stop(void);
+void boot_trace_record(boot_trace_phase phase, uint32_t arg);
+uint32_t boot_trace_now_us(void);
+const boot_trace_buffer* boot_trace_get(void);
+#define BOOT_TRACE_START()      boot_trace_init()
+#define BOOT_TRACE_STOP()       boot_trace_stop()
+#define BOOT_TRACE(phase, arg)  boot_trace_record((phase), (uint32_t)(arg))
+#define BOOT_TRACE_NOW_US()     boot_trace_now_us()
+#define BOOT_TRACE_SET_CPU_HZ(hz)   boot_trace_set_cpu_hz(hz)
+#else
+#define BOOT_TRACE_START()      do {} while (0)
+#define BOOT_TRACE_STOP()       do {} while (0)
+#define BOOT_TRACE(phase, arg)  do {} while (0)
+#define BOOT_TRACE_NOW_US()     0UL
+#define BOOT_TRACE_SET_CPU_HZ(hz)   do {} while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
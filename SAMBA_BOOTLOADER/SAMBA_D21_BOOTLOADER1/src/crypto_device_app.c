@@ -27,14 +27,59 @@
  */
 #include <stdlib.h>
 #include <stdio.h>
+#include <asf.h>
 #include "cryptoauthlib.h"
 #include "secure_boot.h"
 #include "io_protection_key.h"
 #include "crypto_device_app.h"
+#include "crypto_device_cache.h"
+#include "secure_boot_app.h"
+#include "secure_boot_slot.h"
+#include "boot_journal.h"
+#include "boot_trace.h"
 
 #define ATECC608A_MAH22_CONFIG_I2C_ADDR         (0x6A)
 #define ATECC608A_SECURE_BOOT_DEMO_I2C_ADDR     (0x5A)
 #define ATECC608A_DEFAULT_I2C_ADDR              (0xC0)
+#define ATECC608A_INFO_DEVICE_ID                (0x60)
+/** Requested bus rate, Fast-mode Plus. The HAL falls back to 400 kHz when the
+ *  SERCOM clock is too slow and reports the rate in use in the interface cfg */
+#define ATECC608A_I2C_BAUD                      (1000000)
+
+/** \brief Stores the interface of the device found on this boot so that the
+ *         next boot tries it before probing the address list. Only ATECC608A
+ *         revisions are cached, a failure here does not affect secure boot.
+ *  \param[in] ATCAIfaceCfg* cfg Interface the device answered on
+ */
+static void crypto_device_update_cache(ATCAIfaceCfg* cfg)
+{
+    uint8_t revision[CRYPTO_DEVICE_REVISION_SIZE];
+
+    if (atcab_info(revision) != ATCA_SUCCESS)
+    {
+        return;
+    }
+
+    if (revision[2] == ATECC608A_INFO_DEVICE_ID)
+    {
+        crypto_device_cache_set(cfg->atcai2c.slave_address, cfg->atcai2c.bus, revision);
+    }
+}
+
+/** \brief Returns the digest engine cached for the current clock configuration
+ *  \param[in] crypto_device_cache_record* record Cached device
+ */
+static secure_boot_digest_engine_id crypto_device_cached_digest_engine(const crypto_device_cache_record* record)
+{
+    if ((record->cpu_mhz != (system_cpu_clock_get_hz() / 1000000UL)) ||
+        (record->i2c_khz != (ATECC608A_I2C_BAUD / 1000)))
+    {
+        /*Clocks changed, calibrate again */
+        return SECURE_BOOT_DIGEST_ENGINE_UNKNOWN;
+    }
+
+    return (secure_boot_digest_engine_id)record->digest_engine;
+}
 
 /** \brief Takes care interface with secure boot and provides status about user
  *         application. This also takes care of device configuration if enabled.
@@ -51,22 +96,65 @@ ATCA_STATUS crypto_device_verify_app(void)
         .devtype                = ATECC608A,
         .atcai2c.slave_address  = ATECC608A_SECURE_BOOT_DEMO_I2C_ADDR,
         .atcai2c.bus            = 2,
-        .atcai2c.baud           = 400000,
+        .atcai2c.baud           = ATECC608A_I2C_BAUD,
         //.atcai2c.baud = 100000,
         .wake_delay             = 1500,
         .rx_retries             = 20
     };
     uint8_t addr_list[] = {ATECC608A_SECURE_BOOT_DEMO_I2C_ADDR, ATECC608A_MAH22_CONFIG_I2C_ADDR, ATECC608A_DEFAULT_I2C_ADDR};
 	uint8_t sboot_public_key_slot;
+    crypto_device_cache_record cached_device;
+    bool is_cached = false;
+    uint8_t default_bus = cfg_atecc608a_i2c_default.atcai2c.bus;
+    uint8_t failed_address = 0;
 	
+    BOOT_TRACE(BOOT_TRACE_VERIFY_START, 0);
+
     do
     {
         #if CRYPTO_DEVICE_ENABLE_SECURE_BOOT
         bool is_locked;
+        bool has_cache;
 
-        for(uint8_t addr_index=0; addr_index<(sizeof(addr_list)/sizeof(addr_list[0])); addr_index++)
+        /*Digest engine calibrated for this device on a previous boot */
+        secure_boot_app_set_digest_engine(SECURE_BOOT_DIGEST_ENGINE_UNKNOWN);
+        if ((has_cache = crypto_device_cache_get(&cached_device)))
         {
+            secure_boot_app_set_digest_engine(crypto_device_cached_digest_engine(&cached_device));
+        }
+
+        /*Hash the application while waiting on the device */
+        secure_boot_app_start();
+
+        /*Try the interface found on a previous boot first */
+        if (has_cache)
+        {
+            cfg_atecc608a_i2c_default.atcai2c.slave_address = cached_device.slave_address;
+            cfg_atecc608a_i2c_default.atcai2c.bus = cached_device.bus;
+            BOOT_TRACE(BOOT_TRACE_PROBE_ADDRESS, cached_device.slave_address);
+            if ((status = atcab_init(&cfg_atecc608a_i2c_default)) == ATCA_SUCCESS)
+            {
+                is_cached = true;
+            }
+            else
+            {
+                if (cached_device.bus == default_bus)
+                {
+                    /*No need to probe this address again */
+                    failed_address = cached_device.slave_address;
+                }
+                cfg_atecc608a_i2c_default.atcai2c.bus = default_bus;
+            }
+        }
+
+        for(uint8_t addr_index=0; !is_cached && (addr_index<(sizeof(addr_list)/sizeof(addr_list[0]))); addr_index++)
+        {
+            if (addr_list[addr_index] == failed_address)
+            {
+                continue;
+            }
             cfg_atecc608a_i2c_default.atcai2c.slave_address = addr_list[addr_index];
+            BOOT_TRACE(BOOT_TRACE_PROBE_ADDRESS, addr_list[addr_index]);
             if ((status = atcab_init(&cfg_atecc608a_i2c_default)) == ATCA_SUCCESS)
             {
                 /*ECC608A with addr_list[addr_index] address is found */
@@ -77,6 +165,12 @@ ATCA_STATUS crypto_device_verify_app(void)
         /* No ECC608A with matching address found */
         if(status != ATCA_SUCCESS)
             break;
+        BOOT_TRACE(BOOT_TRACE_PROBE_DONE, cfg_atecc608a_i2c_default.atcai2c.slave_address);
+        if (!is_cached)
+        {
+            /*Not the cached device, its digest engine does not apply */
+            secure_boot_app_set_digest_engine(SECURE_BOOT_DIGEST_ENGINE_UNKNOWN);
+        }
 
         /*Check current status of Public Key Slot lock status */
 		if((status = atcab_read_bytes_zone(ATCA_ZONE_CONFIG, 0, SECUREBOOTCONFIG_OFFSET+1, &sboot_public_key_slot, sizeof(sboot_public_key_slot))) != ATCA_SUCCESS)
@@ -104,16 +198,45 @@ ATCA_STATUS crypto_device_verify_app(void)
             #endif
         }
 
-        /*Initiate secure boot operation */
-        if ((status = secure_boot_process()) != ATCA_SUCCESS)
+        /*Remember the interface for the next boot, configuration load may have moved the address */
+        if (!is_cached || (cached_device.slave_address != cfg_atecc608a_i2c_default.atcai2c.slave_address))
+        {
+            crypto_device_update_cache(&cfg_atecc608a_i2c_default);
+        }
+
+        BOOT_TRACE(BOOT_TRACE_LOCK_CHECK_DONE, sboot_public_key_slot);
+
+        /*Initiate secure boot operation, on the slot selected by the caller */
+        status = secure_boot_app_process();
+        BOOT_TRACE(BOOT_TRACE_VERIFY_DONE, status);
+
+        /*Fall back to the image in the other slot */
+        while ((status != ATCA_SUCCESS) && secure_boot_slot_select_next())
+        {
+            BOOT_TRACE(BOOT_TRACE_SLOT_SELECTED, secure_boot_slot_selected());
+            status = secure_boot_app_process();
+            BOOT_TRACE(BOOT_TRACE_VERIFY_DONE, status);
+        }
+        if (status != ATCA_SUCCESS)
         {
             break;
         }
+
+        /*Keep the digest engine calibrated on this boot */
+        crypto_device_cache_set_digest_engine(secure_boot_app_get_digest_engine(), system_cpu_clock_get_hz() / 1000000UL,
+                                              ATECC608A_I2C_BAUD / 1000);
+
+        #if BOOT_JOURNAL_BOOT_COUNT_ENABLED
+        boot_journal_count_boot();
+        #endif
         #endif  //CRYPTO_DEVICE_ENABLE_SECURE_BOOT
 
     }
     while (0);
 
+    #if CRYPTO_DEVICE_ENABLE_SECURE_BOOT
+    secure_boot_app_stop();
+    #endif
 
     return status;
 }
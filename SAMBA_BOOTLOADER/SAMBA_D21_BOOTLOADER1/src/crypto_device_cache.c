@@ -0,0 +1,114 @@
+/**
+ * \file
+ *
+ * \brief Cache of the CryptoAuthentication device interface found on a previous boot.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <string.h>
+#include <asf.h>
+#include "crypto_device_cache.h"
+#include "boot_journal.h"
+
+/** \brief Check value stored with a record, never 0xFFFF for an erased record */
+static uint16_t crypto_device_cache_check(const crypto_device_cache_record* record)
+{
+	return (uint16_t)~((record->slave_address | ((uint16_t)record->bus << 8)) +
+	(record->digest_engine | ((uint16_t)record->cpu_mhz << 8)) + record->i2c_khz);
+}
+
+/** \brief Gets the device interface cached on a previous boot
+ *	\param[out] crypto_device_cache_record* record Cached record
+ *	\return true if a valid record was found
+ */
+bool crypto_device_cache_get(crypto_device_cache_record* record)
+{
+	return boot_journal_read(BOOT_JOURNAL_DEVICE_CACHE, record, sizeof(*record));
+}
+
+/** \brief Stores a record in the boot journal
+ *	\param[in, out] crypto_device_cache_record* record Record to store, check is set here
+ *	\return ATCA_STATUS
+ */
+static ATCA_STATUS crypto_device_cache_store(crypto_device_cache_record* record)
+{
+	record->check = crypto_device_cache_check(record);
+
+	return boot_journal_write(BOOT_JOURNAL_DEVICE_CACHE, record, sizeof(*record));
+}
+
+/** \brief Stores a record for the device interface found on this boot.
+ *         Nothing is written if it matches the cached record. A new device
+ *         has no digest engine until it is calibrated.
+ *	\param[in] uint8_t slave_address 8-bit I2C address
+ *	\param[in] uint8_t bus Logical I2C bus
+ *	\param[in] uint8_t* revision Info command revision
+ *	\return ATCA_STATUS
+ */
+ATCA_STATUS crypto_device_cache_set(uint8_t slave_address, uint8_t bus, const uint8_t* revision)
+{
+	crypto_device_cache_record record;
+
+	if(crypto_device_cache_get(&record) && (record.slave_address == slave_address) && (record.bus == bus) &&
+	(0 == memcmp(record.revision, revision, CRYPTO_DEVICE_REVISION_SIZE)))
+	{
+		return ATCA_SUCCESS;
+	}
+
+	memset(&record, 0, sizeof(record));
+	record.slave_address = slave_address;
+	record.bus = bus;
+	memcpy(record.revision, revision, CRYPTO_DEVICE_REVISION_SIZE);
+
+	return crypto_device_cache_store(&record);
+}
+
+/** \brief Stores the digest engine chosen for the cached device at the given
+ *         clock configuration. Nothing is written if it is already cached.
+ *	\param[in] uint8_t digest_engine secure_boot_digest_engine_id
+ *	\param[in] uint8_t cpu_mhz Core clock
+ *	\param[in] uint16_t i2c_khz I2C clock
+ *	\return ATCA_STATUS
+ */
+ATCA_STATUS crypto_device_cache_set_digest_engine(uint8_t digest_engine, uint8_t cpu_mhz, uint16_t i2c_khz)
+{
+	crypto_device_cache_record record;
+
+	if(!crypto_device_cache_get(&record))
+	{
+		return ATCA_GEN_FAIL;
+	}
+
+	if((record.digest_engine == digest_engine) && (record.cpu_mhz == cpu_mhz) && (record.i2c_khz == i2c_khz))
+	{
+		return ATCA_SUCCESS;
+	}
+
+	record.digest_engine = digest_engine;
+	record.cpu_mhz = cpu_mhz;
+	record.i2c_khz = i2c_khz;
+
+	return crypto_device_cache_store(&record);
+}
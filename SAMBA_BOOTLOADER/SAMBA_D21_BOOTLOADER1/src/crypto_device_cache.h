@@ -0,0 +1,65 @@
+/**
+ * \file
+ *
+ * \brief Cache of the CryptoAuthentication device interface found on a previous boot.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef CRYPTO_DEVICE_CACHE_H
+#define CRYPTO_DEVICE_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "atca_status.h"
+
+/** Size of the revision returned by the Info command */
+#define CRYPTO_DEVICE_REVISION_SIZE         4
+
+/** \brief One cache record, kept in the boot journal */
+typedef struct
+{
+	uint8_t slave_address;                              /**< 8-bit I2C address */
+	uint8_t bus;                                        /**< Logical I2C bus */
+	uint16_t check;                                     /**< See crypto_device_cache_check() */
+	uint8_t revision[CRYPTO_DEVICE_REVISION_SIZE];      /**< Info command revision */
+	uint8_t digest_engine;                              /**< Fastest secure_boot_digest_engine_id */
+	uint8_t cpu_mhz;                                    /**< Core clock digest_engine was calibrated at */
+	uint16_t i2c_khz;                                   /**< Requested I2C clock digest_engine was calibrated at */
+	uint8_t reserved[4];
+} crypto_device_cache_record;
+
+bool crypto_device_cache_get(crypto_device_cache_record* record);
+ATCA_STATUS crypto_device_cache_set(uint8_t slave_address, uint8_t bus, const uint8_t* revision);
+ATCA_STATUS crypto_device_cache_set_digest_engine(uint8_t digest_engine, uint8_t cpu_mhz, uint16_t i2c_khz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
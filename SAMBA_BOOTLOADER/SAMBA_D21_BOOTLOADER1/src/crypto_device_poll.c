@@ -0,0 +1,223 @@
+/**
+ * \file
+ *
+ * \brief Adaptive ATECC608A command completion polling.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+#include <stddef.h>
+#include "cryptoauthlib.h"
+#include "crypto_device_poll.h"
+
+/*
+ * CryptoAuthLib waits a fixed time after sending a command and then polls at
+ * a fixed interval, the HAL retrying each read rx_retries times. The I2C HAL
+ * takes this over: once a command is sent, the CryptoAuthLib delays are
+ * skipped and the next receive waits the learned latency of the opcode,
+ * then polls with a geometric back-off until the device answers. The wake
+ * response is handled the same way instead of the fixed wake_delay.
+ *
+ * The table starts from typical execution times. A first poll that is
+ * answered lowers the estimate by an eighth, one that is not raises it to
+ * the latency observed, so it settles just above the real latency.
+ */
+
+/** Shortest delay and back-off step */
+#define CRYPTO_DEVICE_POLL_MIN_US           50
+/** Back-off steps stop growing here */
+#define CRYPTO_DEVICE_POLL_MAX_STEP_US      4000
+/** Counters saturate instead of wrapping */
+#define CRYPTO_DEVICE_POLL_COUNT_MAX        0xFFFF
+
+static crypto_device_poll_entry crypto_device_poll_entries[] =
+{
+	/* opcode, variant, counts, typical, maximum */
+	{ CRYPTO_DEVICE_POLL_WAKE, 0, 0, 0, 0,  1500,   3000 },
+	{ ATCA_READ,            0, 0, 0, 0,     800,    5000 },
+	{ ATCA_WRITE,           0, 0, 0, 0,     7000,   45000 },
+	{ ATCA_LOCK,            0, 0, 0, 0,     8000,   35000 },
+	{ ATCA_RANDOM,          0, 0, 0, 0,     1500,   23000 },
+	{ ATCA_NONCE,           0, 0, 0, 0,     1500,   20000 },
+	{ ATCA_INFO,            0, 0, 0, 0,     500,    5000 },
+	{ ATCA_SHA,             0, 0, 0, 0,     1200,   36000 },
+	{ ATCA_GENDIG,          0, 0, 0, 0,     5000,   25000 },
+	{ ATCA_GENKEY,          0, 0, 0, 0,     60000,  115000 },
+	{ ATCA_VERIFY,          0, 0, 0, 0,     40000,  105000 },
+	/* Digest only, compared with the stored one */
+	{ ATCA_SECUREBOOT,      0, 0, 0, 0,     2000,   80000 },
+	{ ATCA_SECUREBOOT,      CRYPTO_DEVICE_POLL_VARIANT_SIGNATURE, 0, 0, 0, 40000, 80000 },
+};
+
+/** Entry for opcodes not in the table, never learned */
+static crypto_device_poll_entry crypto_device_poll_default = { 0xFF, 0, 0, 0, 0, 1000, 250000 };
+
+static crypto_device_poll_entry* crypto_device_poll_current;
+
+static void crypto_device_poll_count(uint16_t* counter)
+{
+	if (*counter < CRYPTO_DEVICE_POLL_COUNT_MAX)
+	{
+		(*counter)++;
+	}
+}
+
+/** \brief Starts tracking a command sent to the device
+ *  \param[in] uint8_t opcode Command opcode, CRYPTO_DEVICE_POLL_WAKE after the wake pulse
+ *  \param[in] uint16_t data_length Length of the command data field
+ */
+void crypto_device_poll_start(uint8_t opcode, uint16_t data_length)
+{
+	uint8_t variant = 0;
+	uint8_t index;
+
+	if ((opcode == ATCA_SECUREBOOT) && (data_length > ATCA_SHA_DIGEST_SIZE))
+	{
+		variant = CRYPTO_DEVICE_POLL_VARIANT_SIGNATURE;
+	}
+
+	crypto_device_poll_current = &crypto_device_poll_default;
+	for (index = 0; index < (sizeof(crypto_device_poll_entries) / sizeof(crypto_device_poll_entries[0])); index++)
+	{
+		if ((crypto_device_poll_entries[index].opcode == opcode) && (crypto_device_poll_entries[index].variant == variant))
+		{
+			crypto_device_poll_current = &crypto_device_poll_entries[index];
+			break;
+		}
+	}
+}
+
+/** \brief Forgets the command in flight, the bus is used for something else */
+void crypto_device_poll_cancel(void)
+{
+	crypto_device_poll_current = NULL;
+}
+
+/** \brief Returns true while a command is in flight. CryptoAuthLib delays are
+ *         skipped then, the receive does the waiting.
+ */
+bool crypto_device_poll_pending(void)
+{
+	return (crypto_device_poll_current != NULL);
+}
+
+/** \brief Waits for the command in flight to complete and learns its latency
+ *  \param[in] crypto_device_poll_fn poll Reads the response once
+ *  \param[in] void* arg Argument of poll
+ *  \param[in] uint32_t poll_us Bus time of a poll that is not acknowledged
+ *  \return ATCA_SUCCESS once poll succeeded, the last poll status on timeout
+ */
+ATCA_STATUS crypto_device_poll_complete(crypto_device_poll_fn poll, void* arg, uint32_t poll_us)
+{
+	crypto_device_poll_entry* entry = crypto_device_poll_current;
+	ATCA_STATUS status;
+	uint32_t elapsed_us = 0;
+	uint32_t wait_us;
+	uint32_t step_us;
+	bool first = true;
+
+	if (entry == NULL)
+	{
+		return poll(arg);
+	}
+
+	wait_us = entry->estimate_us;
+	step_us = entry->estimate_us / 8;
+	if (step_us < CRYPTO_DEVICE_POLL_MIN_US)
+	{
+		step_us = CRYPTO_DEVICE_POLL_MIN_US;
+	}
+
+	for (;;)
+	{
+		crypto_device_poll_delay_us(wait_us);
+		elapsed_us += wait_us;
+
+		if ((status = poll(arg)) == ATCA_SUCCESS)
+		{
+			break;
+		}
+		elapsed_us += poll_us;
+		if (elapsed_us >= entry->max_us)
+		{
+			break;
+		}
+		crypto_device_poll_count(&entry->polls);
+		first = false;
+
+		/* Geometric back-off */
+		wait_us = step_us;
+		if (step_us < CRYPTO_DEVICE_POLL_MAX_STEP_US)
+		{
+			step_us *= 2;
+		}
+	}
+
+	crypto_device_poll_current = NULL;
+	if (entry == &crypto_device_poll_default)
+	{
+		return status;
+	}
+
+	if (status != ATCA_SUCCESS)
+	{
+		/* Device absent or failing, nothing to learn */
+		crypto_device_poll_count(&entry->timeouts);
+		return status;
+	}
+
+	crypto_device_poll_count(&entry->completions);
+	if ((entry->min_seen_us == 0) || (elapsed_us < entry->min_seen_us))
+	{
+		entry->min_seen_us = elapsed_us;
+	}
+	if (elapsed_us > entry->max_seen_us)
+	{
+		entry->max_seen_us = elapsed_us;
+	}
+
+	if (first)
+	{
+		/* Answered at once, try earlier next time */
+		entry->estimate_us -= entry->estimate_us / 8;
+		if (entry->estimate_us < CRYPTO_DEVICE_POLL_MIN_US)
+		{
+			entry->estimate_us = CRYPTO_DEVICE_POLL_MIN_US;
+		}
+	}
+	else
+	{
+		entry->estimate_us = elapsed_us;
+	}
+
+	return status;
+}
+
+/** \brief Returns the latency table for instrumentation
+ *  \param[out] uint8_t* count Number of entries
+ */
+const crypto_device_poll_entry* crypto_device_poll_table(uint8_t* count)
+{
+	*count = sizeof(crypto_device_poll_entries) / sizeof(crypto_device_poll_entries[0]);
+	return crypto_device_poll_entries;
+}
@@ -0,0 +1,78 @@
+/**
+ * \file
+ *
+ * \brief Adaptive ATECC608A command completion polling.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef CRYPTO_DEVICE_POLL_H
+#define CRYPTO_DEVICE_POLL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "atca_status.h"
+
+/** Pseudo opcode of the wake response */
+#define CRYPTO_DEVICE_POLL_WAKE             0x00
+/** Variant of a SecureBoot command that carries the signature */
+#define CRYPTO_DEVICE_POLL_VARIANT_SIGNATURE    1
+
+/** \brief Observed completion latencies of one command, all times in microseconds.
+ *         Latencies are measured in wait time, so they are upper bounds. */
+typedef struct
+{
+	uint8_t opcode;             /**< Command opcode or CRYPTO_DEVICE_POLL_WAKE */
+	uint8_t variant;            /**< CRYPTO_DEVICE_POLL_VARIANT_x, 0 for the plain command */
+	uint16_t completions;
+	uint16_t polls;             /**< Polls the device did not acknowledge */
+	uint16_t timeouts;
+	uint32_t estimate_us;       /**< Delay before the first poll, learned */
+	uint32_t max_us;            /**< Datasheet maximum, polling gives up after it */
+	uint32_t min_seen_us;
+	uint32_t max_seen_us;
+} crypto_device_poll_entry;
+
+/** \brief One poll of the device, returns ATCA_SUCCESS once it answers */
+typedef ATCA_STATUS (*crypto_device_poll_fn)(void* arg);
+
+void crypto_device_poll_start(uint8_t opcode, uint16_t data_length);
+void crypto_device_poll_cancel(void);
+bool crypto_device_poll_pending(void);
+ATCA_STATUS crypto_device_poll_complete(crypto_device_poll_fn poll, void* arg, uint32_t poll_us);
+const crypto_device_poll_entry* crypto_device_poll_table(uint8_t* count);
+
+/* Busy wait that is not taken over by the polling engine, implemented next
+ * to the delay routines in the timer HAL */
+void crypto_device_poll_delay_us(uint32_t delay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
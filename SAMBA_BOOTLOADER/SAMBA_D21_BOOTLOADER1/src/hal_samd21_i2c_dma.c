@@ -0,0 +1,499 @@
+/**
+ * \file
+ *
+ * \brief CryptoAuthLib I2C HAL for SAMD21 SERCOM with DMA transfers.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+#include <asf.h>
+#include <string.h>
+#include "cryptoauthlib.h"
+#include "hal/atca_hal.h"
+#include "secure_boot_app.h"
+#include "crypto_device_poll.h"
+
+/*
+ * Replaces hal_samd21_i2c_asf.c. Bus setup, speed changes and the wake pulse
+ * still go through the ASF I2C master driver, command and response bytes are
+ * moved by a DMAC channel with the SERCOM length counter (ADDR.LENEN), which
+ * sends the final NACK and STOP itself. While a transfer runs the CPU
+ * advances the background application digest instead of feeding DATA.
+ *
+ * Command completion and the wake response are waited for here with the
+ * learned per-opcode latencies of crypto_device_poll.c, the CryptoAuthLib
+ * delays are skipped while a command is in flight.
+ *
+ * Rates above 400 kHz use Fast-mode Plus. The SERCOM baud generator needs a
+ * GCLK of about 13 MHz for 1 MHz, below that the bus falls back to 400 kHz
+ * and the rate in use is written back to the interface configuration.
+ */
+
+#define MAX_I2C_BUSES               6
+#define HAL_I2C_WAKE_BAUD           100000
+#define HAL_I2C_FAST_MODE_BAUD      400000
+/** Polling loops the ASF driver waits for the bus, setup and wake only */
+#define HAL_I2C_TIMEOUT             10000
+/** Time allowed on top of twice the bus time of a transfer, for clock
+ *  stretching and the SERCOM and DMAC latencies */
+#define HAL_I2C_TIMEOUT_MARGIN_US   1000
+/** SysTick reload value, shared with the boot trace and the timer HAL */
+#define HAL_I2C_SYSTICK_RELOAD      0x00FFFFFFUL
+/** DMAC channel reserved for the device bus, the descriptors only cover channel 0 */
+#define HAL_I2C_DMA_CHANNEL         0
+/** Largest transfer ADDR.LEN can count */
+#define HAL_I2C_DMA_MAX_LENGTH      255
+
+typedef struct
+{
+	struct i2c_master_module i2c_master_instance;
+	uint32_t baud;          /**< Rate the SERCOM runs at */
+	int ref_ct;
+} hal_i2c_dma_bus;
+
+/** Response read polled by crypto_device_poll_complete() */
+typedef struct
+{
+	int bus;
+	uint8_t slave_address;
+	uint8_t* data;
+	uint16_t length;
+} hal_i2c_dma_read;
+
+static hal_i2c_dma_bus i2c_hal_data[MAX_I2C_BUSES];
+static int i2c_bus_ref_ct = 0;
+
+static Sercom* const i2c_sercoms[MAX_I2C_BUSES] = { SERCOM0, SERCOM1, SERCOM2, SERCOM3, SERCOM4, SERCOM5 };
+static const uint8_t i2c_dmac_tx_ids[MAX_I2C_BUSES] = {
+	SERCOM0_DMAC_ID_TX, SERCOM1_DMAC_ID_TX, SERCOM2_DMAC_ID_TX,
+	SERCOM3_DMAC_ID_TX, SERCOM4_DMAC_ID_TX, SERCOM5_DMAC_ID_TX
+};
+static const uint8_t i2c_dmac_rx_ids[MAX_I2C_BUSES] = {
+	SERCOM0_DMAC_ID_RX, SERCOM1_DMAC_ID_RX, SERCOM2_DMAC_ID_RX,
+	SERCOM3_DMAC_ID_RX, SERCOM4_DMAC_ID_RX, SERCOM5_DMAC_ID_RX
+};
+
+/** DMAC descriptor and write-back sections, channel 0 only */
+static DmacDescriptor hal_i2c_dma_descriptor __attribute__((aligned(16)));
+static DmacDescriptor hal_i2c_dma_writeback __attribute__((aligned(16)));
+
+/**
+ * \brief Enable the DMAC with the descriptor sections of this HAL
+ */
+static void hal_i2c_dma_enable(void)
+{
+	PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+	PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+
+	DMAC->CTRL.reg = 0;
+	DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+	while (DMAC->CTRL.reg & DMAC_CTRL_SWRST) {
+	}
+
+	DMAC->BASEADDR.reg = (uint32_t)&hal_i2c_dma_descriptor;
+	DMAC->WRBADDR.reg = (uint32_t)&hal_i2c_dma_writeback;
+	DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+}
+
+/**
+ * \brief Disable the DMAC so the application starts with it in reset state
+ */
+static void hal_i2c_dma_disable(void)
+{
+	DMAC->CTRL.reg = 0;
+	DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+	while (DMAC->CTRL.reg & DMAC_CTRL_SWRST) {
+	}
+}
+
+/**
+ * \brief (Re)configure the SERCOM for the given rate, falling back to
+ *        400 kHz if the GCLK is too slow for Fast-mode Plus
+ */
+static enum status_code hal_i2c_configure(int bus, uint32_t baud)
+{
+	struct i2c_master_config config_i2c_master;
+	enum status_code status;
+
+	if (i2c_hal_data[bus].i2c_master_instance.hw != NULL) {
+		i2c_master_disable(&i2c_hal_data[bus].i2c_master_instance);
+	}
+
+	i2c_master_get_config_defaults(&config_i2c_master);
+	config_i2c_master.buffer_timeout = HAL_I2C_TIMEOUT;
+	config_i2c_master.baud_rate = baud / 1000;
+	if (baud > HAL_I2C_FAST_MODE_BAUD) {
+		config_i2c_master.transfer_speed = I2C_MASTER_SPEED_FAST_MODE_PLUS;
+	}
+
+	status = i2c_master_init(&i2c_hal_data[bus].i2c_master_instance, i2c_sercoms[bus], &config_i2c_master);
+	if ((status == STATUS_ERR_BAUDRATE_UNAVAILABLE) && (baud > HAL_I2C_FAST_MODE_BAUD)) {
+		baud = HAL_I2C_FAST_MODE_BAUD;
+		config_i2c_master.baud_rate = baud / 1000;
+		config_i2c_master.transfer_speed = I2C_MASTER_SPEED_STANDARD_AND_FAST;
+		status = i2c_master_init(&i2c_hal_data[bus].i2c_master_instance, i2c_sercoms[bus], &config_i2c_master);
+	}
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	i2c_master_enable(&i2c_hal_data[bus].i2c_master_instance);
+	i2c_hal_data[bus].baud = baud;
+
+	return STATUS_OK;
+}
+
+/**
+ * \brief Bus time of a transfer in microseconds: START, address, data with
+ *        their ACK bits and STOP
+ */
+static uint32_t hal_i2c_transfer_us(uint32_t baud, uint16_t length)
+{
+	return ((2 + 9 * (1 + (uint32_t)length)) * 1000000UL) / baud;
+}
+
+/**
+ * \brief Abort a transfer: stop the channel and release the bus
+ */
+static void hal_i2c_dma_abort(hal_i2c_dma_bus* i2c_bus)
+{
+	SercomI2cm* const i2c_module = &i2c_bus->i2c_master_instance.hw->I2CM;
+
+	DMAC->CHID.reg = DMAC_CHID_ID(HAL_I2C_DMA_CHANNEL);
+	DMAC->CHCTRLA.reg = 0;
+	while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_ENABLE) {
+	}
+
+	if ((i2c_module->STATUS.reg & SERCOM_I2CM_STATUS_BUSSTATE_Msk) == SERCOM_I2CM_STATUS_BUSSTATE(2)) {
+		i2c_module->CTRLB.reg |= SERCOM_I2CM_CTRLB_CMD(3);
+		while (i2c_master_is_syncing(&i2c_bus->i2c_master_instance)) {
+		}
+	}
+	i2c_module->INTFLAG.reg = SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB | SERCOM_I2CM_INTFLAG_ERROR;
+}
+
+/**
+ * \brief Move one transaction with the DMAC
+ * \param[in] int bus Logical bus
+ * \param[in] uint8_t slave_address 8-bit I2C address
+ * \param[in, out] uint8_t* data Bytes to send or receive
+ * \param[in] uint16_t length Number of bytes, 1 to HAL_I2C_DMA_MAX_LENGTH
+ * \param[in] enum i2c_transfer_direction direction Write or read
+ * \return ATCA_SUCCESS if the device acknowledged every byte it had to
+ */
+static ATCA_STATUS hal_i2c_dma_transfer(int bus, uint8_t slave_address, uint8_t* data, uint16_t length,
+		enum i2c_transfer_direction direction)
+{
+	hal_i2c_dma_bus* i2c_bus = &i2c_hal_data[bus];
+	SercomI2cm* const i2c_module = &i2c_bus->i2c_master_instance.hw->I2CM;
+	ATCA_STATUS result = ATCA_COMM_FAIL;
+	bool own_systick = false;
+	uint32_t timeout, elapsed = 0, last, count;
+	uint8_t intflag;
+	uint16_t status;
+
+	/* The transfer is abandoned after a time derived from its length and
+	 * the bus rate, measured in core cycles with SysTick */
+	if (!(SysTick->CTRL & SysTick_CTRL_ENABLE_Msk)) {
+		SysTick->LOAD = HAL_I2C_SYSTICK_RELOAD;
+		SysTick->VAL = 0;
+		SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+		own_systick = true;
+	}
+	timeout = (2 * hal_i2c_transfer_us(i2c_bus->baud, length) + HAL_I2C_TIMEOUT_MARGIN_US)
+			* (system_cpu_clock_get_hz() / 1000000UL);
+	last = SysTick->VAL;
+
+	hal_i2c_dma_descriptor.BTCNT.reg = length;
+	hal_i2c_dma_descriptor.DESCADDR.reg = 0;
+	if (direction == I2C_TRANSFER_WRITE) {
+		/* Incrementing addresses point past the end of the block */
+		hal_i2c_dma_descriptor.BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_SRCINC;
+		hal_i2c_dma_descriptor.SRCADDR.reg = (uint32_t)(data + length);
+		hal_i2c_dma_descriptor.DSTADDR.reg = (uint32_t)&i2c_module->DATA.reg;
+	} else {
+		hal_i2c_dma_descriptor.BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_DSTINC;
+		hal_i2c_dma_descriptor.SRCADDR.reg = (uint32_t)&i2c_module->DATA.reg;
+		hal_i2c_dma_descriptor.DSTADDR.reg = (uint32_t)(data + length);
+	}
+
+	DMAC->CHID.reg = DMAC_CHID_ID(HAL_I2C_DMA_CHANNEL);
+	DMAC->CHCTRLB.reg = DMAC_CHCTRLB_TRIGACT_BEAT | DMAC_CHCTRLB_TRIGSRC(
+			(direction == I2C_TRANSFER_WRITE) ? i2c_dmac_tx_ids[bus] : i2c_dmac_rx_ids[bus]);
+	DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+	DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+
+	/* Writing the address with its length starts the transaction */
+	i2c_master_dma_set_transfer(&i2c_bus->i2c_master_instance, slave_address >> 1, length, direction);
+	while (i2c_master_is_syncing(&i2c_bus->i2c_master_instance)) {
+	}
+
+	/* The transfer runs on its own, use the bus time for the digest */
+	secure_boot_app_background(hal_i2c_transfer_us(i2c_bus->baud, length));
+
+	for (;;) {
+		intflag = i2c_module->INTFLAG.reg;
+		status = i2c_module->STATUS.reg;
+
+		if ((intflag & SERCOM_I2CM_INTFLAG_ERROR) || (status & (SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST)) ||
+				((intflag & SERCOM_I2CM_INTFLAG_MB) && (status & SERCOM_I2CM_STATUS_RXNACK))) {
+			/* Address or data not acknowledged, the device is busy or absent */
+			break;
+		}
+
+		DMAC->CHID.reg = DMAC_CHID_ID(HAL_I2C_DMA_CHANNEL);
+		if ((DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL) &&
+				((status & SERCOM_I2CM_STATUS_BUSSTATE_Msk) != SERCOM_I2CM_STATUS_BUSSTATE(2))) {
+			/* Last byte moved and STOP sent */
+			DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+			result = ATCA_SUCCESS;
+			break;
+		}
+
+		/* Down counter, the mask handles a reload in between. Completion
+		 * is checked at least once after the background step. */
+		count = SysTick->VAL;
+		elapsed += (last - count) & HAL_I2C_SYSTICK_RELOAD;
+		last = count;
+		if (elapsed > timeout) {
+			break;
+		}
+	}
+
+	if (own_systick) {
+		SysTick->CTRL = 0;
+	}
+	if (result != ATCA_SUCCESS) {
+		hal_i2c_dma_abort(i2c_bus);
+	}
+
+	return result;
+}
+
+/**
+ * \brief One response read for crypto_device_poll_complete()
+ */
+static ATCA_STATUS hal_i2c_dma_poll(void* arg)
+{
+	hal_i2c_dma_read* read = (hal_i2c_dma_read*)arg;
+
+	return hal_i2c_dma_transfer(read->bus, read->slave_address, read->data, read->length, I2C_TRANSFER_READ);
+}
+
+/**
+ * \brief Read a response, waiting for the command in flight if there is one
+ */
+static ATCA_STATUS hal_i2c_dma_read_response(ATCAIfaceCfg* cfg, int bus, uint8_t* data, uint16_t length)
+{
+	int retries = cfg->rx_retries;
+	ATCA_STATUS status = ATCA_COMM_FAIL;
+	hal_i2c_dma_read read = {
+		.bus            = bus,
+		.slave_address  = cfg->atcai2c.slave_address,
+		.data           = data,
+		.length         = length,
+	};
+
+	if (crypto_device_poll_pending()) {
+		/* Not acknowledged polls only cost the address byte */
+		return crypto_device_poll_complete(hal_i2c_dma_poll, &read, hal_i2c_transfer_us(i2c_hal_data[bus].baud, 0));
+	}
+
+	while ((retries-- > 0) && (status != ATCA_SUCCESS)) {
+		status = hal_i2c_dma_poll(&read);
+	}
+
+	return status;
+}
+
+/**
+ * \brief Initialize the bus given by cfg->atcai2c.bus, SERCOMn for bus n
+ */
+ATCA_STATUS hal_i2c_init(void* hal, ATCAIfaceCfg* cfg)
+{
+	int bus = cfg->atcai2c.bus;
+	ATCAHAL_t* phal = (ATCAHAL_t*)hal;
+
+	if ((bus < 0) || (bus >= MAX_I2C_BUSES)) {
+		return ATCA_COMM_FAIL;
+	}
+
+	if (i2c_hal_data[bus].ref_ct == 0) {
+		if (i2c_bus_ref_ct == 0) {
+			hal_i2c_dma_enable();
+		}
+		if (hal_i2c_configure(bus, cfg->atcai2c.baud) != STATUS_OK) {
+			if (i2c_bus_ref_ct == 0) {
+				hal_i2c_dma_disable();
+			}
+			return ATCA_COMM_FAIL;
+		}
+		i2c_bus_ref_ct++;
+	}
+	i2c_hal_data[bus].ref_ct++;
+
+	/* Report the rate the bus actually runs at */
+	cfg->atcai2c.baud = i2c_hal_data[bus].baud;
+	phal->hal_data = &i2c_hal_data[bus];
+
+	return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_i2c_post_init(ATCAIface iface)
+{
+	return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_i2c_send(ATCAIface iface, uint8_t* txdata, int txlength)
+{
+	ATCAIfaceCfg* cfg = atgetifacecfg(iface);
+	ATCA_STATUS status;
+
+	txdata[0] = 0x03;   // insert the Word Address Value, Command token
+	txlength++;         // account for word address value byte.
+
+	if (txlength > HAL_I2C_DMA_MAX_LENGTH) {
+		return ATCA_COMM_FAIL;
+	}
+
+	crypto_device_poll_cancel();
+	status = hal_i2c_dma_transfer(cfg->atcai2c.bus, cfg->atcai2c.slave_address, txdata, txlength, I2C_TRANSFER_WRITE);
+	if ((status == ATCA_SUCCESS) && (txlength >= ATCA_CMD_SIZE_MIN + 1)) {
+		/* Count, opcode, param1, param2 and CRC around the data */
+		crypto_device_poll_start(txdata[2], txdata[1] - ATCA_CMD_SIZE_MIN);
+	}
+
+	return status;
+}
+
+ATCA_STATUS hal_i2c_receive(ATCAIface iface, uint8_t* rxdata, uint16_t* rxlength)
+{
+	ATCAIfaceCfg* cfg = atgetifacecfg(iface);
+
+	if ((*rxlength == 0) || (*rxlength > HAL_I2C_DMA_MAX_LENGTH)) {
+		return ATCA_COMM_FAIL;
+	}
+
+	return hal_i2c_dma_read_response(cfg, cfg->atcai2c.bus, rxdata, *rxlength);
+}
+
+static void change_i2c_speed(ATCAIface iface, uint32_t speed)
+{
+	ATCAIfaceCfg* cfg = atgetifacecfg(iface);
+
+	hal_i2c_configure(cfg->atcai2c.bus, speed);
+}
+
+ATCA_STATUS hal_i2c_wake(ATCAIface iface)
+{
+	ATCAIfaceCfg* cfg = atgetifacecfg(iface);
+	int bus = cfg->atcai2c.bus;
+	uint32_t bdrt = cfg->atcai2c.baud;
+	ATCA_STATUS status = ATCA_COMM_FAIL;
+	uint8_t data[4], expected[4] = { 0x04, 0x11, 0x33, 0x43 };
+	struct i2c_master_packet packet = {
+		.address            = 0x00,
+		.data_length        = 0,
+		.data               = data,
+		.ten_bit_address    = false,
+		.high_speed         = false,
+		.hs_master_code     = 0x0,
+	};
+
+	if (bdrt != HAL_I2C_WAKE_BAUD) {    // if not already at 100KHz, change it
+		change_i2c_speed(iface, HAL_I2C_WAKE_BAUD);
+	}
+
+	/* Address 0x00 holds SDA low long enough to wake the device, it is not acknowledged */
+	i2c_master_write_packet_wait(&i2c_hal_data[bus].i2c_master_instance, &packet);
+
+	/* The wake response is polled for like a command response */
+	crypto_device_poll_start(CRYPTO_DEVICE_POLL_WAKE, 0);
+	status = hal_i2c_dma_read_response(cfg, bus, data, sizeof(data));
+
+	// if necessary, revert baud rate to what came in.
+	if (bdrt != HAL_I2C_WAKE_BAUD) {
+		change_i2c_speed(iface, bdrt);
+	}
+
+	if (status != ATCA_SUCCESS) {
+		return ATCA_COMM_FAIL;
+	}
+
+	if (memcmp(data, expected, 4) == 0) {
+		return ATCA_SUCCESS;
+	}
+
+	return ATCA_COMM_FAIL;
+}
+
+static ATCA_STATUS send_word_address(ATCAIface iface, uint8_t word_address)
+{
+	ATCAIfaceCfg* cfg = atgetifacecfg(iface);
+
+	return hal_i2c_dma_transfer(cfg->atcai2c.bus, cfg->atcai2c.slave_address, &word_address, sizeof(word_address), I2C_TRANSFER_WRITE);
+}
+
+ATCA_STATUS hal_i2c_idle(ATCAIface iface)
+{
+	crypto_device_poll_cancel();
+	return send_word_address(iface, 0x02);
+}
+
+ATCA_STATUS hal_i2c_sleep(ATCAIface iface)
+{
+	crypto_device_poll_cancel();
+	return send_word_address(iface, 0x01);
+}
+
+/**
+ * \brief Release the bus, the DMAC is reset with the last bus
+ */
+ATCA_STATUS hal_i2c_release(void* hal_data)
+{
+	hal_i2c_dma_bus* i2c_bus = (hal_i2c_dma_bus*)hal_data;
+
+	if ((i2c_bus == NULL) || (i2c_bus->ref_ct <= 0)) {
+		return ATCA_SUCCESS;
+	}
+
+	if (--i2c_bus->ref_ct == 0) {
+		i2c_master_reset(&i2c_bus->i2c_master_instance);
+		i2c_bus->i2c_master_instance.hw = NULL;
+		if (--i2c_bus_ref_ct == 0) {
+			hal_i2c_dma_disable();
+		}
+	}
+
+	return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_i2c_discover_buses(int i2c_buses[], int max_buses)
+{
+	return ATCA_UNIMPLEMENTED;
+}
+
+ATCA_STATUS hal_i2c_discover_devices(int bus_num, ATCAIfaceCfg cfg[], int* found)
+{
+	return ATCA_UNIMPLEMENTED;
+}
@@ -0,0 +1,127 @@
+/**
+ * \file
+ *
+ * \brief CryptoAuthLib delay HAL for the SAMD21 bootloader, hashes the application during delays.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+#include <asf.h>
+#include <delay.h>
+#include "hal/atca_hal.h"
+#include "secure_boot_app.h"
+#include "crypto_device_poll.h"
+
+/*
+ * Replaces hal_samd21_timer_asf.c. Device waits (wake, command execution,
+ * polling) come through these delays, they first advance the background
+ * application digest and busy wait for whatever is left. While a command is
+ * in flight the I2C HAL waits for it (crypto_device_poll.c) and the
+ * CryptoAuthLib delays return at once.
+ */
+
+/** SysTick reload value, the counter is 24 bits wide */
+#define PIPELINE_SYSTICK_RELOAD     0x00FFFFFFUL
+
+static uint32_t pipeline_cycles_per_us;
+static uint32_t pipeline_last_count;
+static uint32_t pipeline_elapsed_us;
+static uint32_t pipeline_residual_cycles;
+static bool pipeline_owns_systick;
+
+/**
+ * \brief Start the microsecond clock. SysTick is shared with the boot trace,
+ *        it is only enabled here (without interrupt) if nobody runs it.
+ */
+void secure_boot_app_clock_start(void)
+{
+	if (!(SysTick->CTRL & SysTick_CTRL_ENABLE_Msk)) {
+		SysTick->LOAD = PIPELINE_SYSTICK_RELOAD;
+		SysTick->VAL = 0;
+		SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+		pipeline_owns_systick = true;
+	}
+
+	pipeline_cycles_per_us = system_cpu_clock_get_hz() / 1000000UL;
+	pipeline_last_count = SysTick->VAL;
+	pipeline_elapsed_us = 0;
+	pipeline_residual_cycles = 0;
+}
+
+/**
+ * \brief Microseconds since secure_boot_app_clock_start(). Only differences
+ *        between calls less than a SysTick period (2 s at 8 MHz) apart are
+ *        meaningful, which covers a background step.
+ */
+uint32_t secure_boot_app_clock_us(void)
+{
+	uint32_t count = SysTick->VAL;
+	uint32_t cycles;
+
+	/* Down counter, the mask handles a reload in between */
+	cycles = ((pipeline_last_count - count) & PIPELINE_SYSTICK_RELOAD) + pipeline_residual_cycles;
+	pipeline_last_count = count;
+	pipeline_elapsed_us += cycles / pipeline_cycles_per_us;
+	pipeline_residual_cycles = cycles % pipeline_cycles_per_us;
+
+	return pipeline_elapsed_us;
+}
+
+/**
+ * \brief Stop the microsecond clock, SysTick is left as found
+ */
+void secure_boot_app_clock_stop(void)
+{
+	if (pipeline_owns_systick) {
+		SysTick->CTRL = 0;
+		pipeline_owns_systick = false;
+	}
+}
+
+void crypto_device_poll_delay_us(uint32_t delay)
+{
+	uint32_t used = secure_boot_app_background(delay);
+
+	if (used < delay) {
+		delay_us(delay - used);
+	}
+}
+
+void atca_delay_us(uint32_t delay)
+{
+	if (crypto_device_poll_pending()) {
+		return;
+	}
+
+	crypto_device_poll_delay_us(delay);
+}
+
+void atca_delay_10us(uint32_t delay)
+{
+	atca_delay_us(delay * 10);
+}
+
+void atca_delay_ms(uint32_t delay)
+{
+	atca_delay_us(delay * 1000);
+}
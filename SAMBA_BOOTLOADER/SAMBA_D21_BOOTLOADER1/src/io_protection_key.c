@@ -28,6 +28,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <asf.h>
 #include "io_protection_key.h"
 #include "memory_conf.h"
@@ -37,7 +38,10 @@
 
 
 
-/** \brief This function helps to read IO protection value from specified address.
+/** \brief This function helps to read IO protection value from the page below
+ *         the application, which BOOTPROT covers after binding. The key is
+ *         never taken from application flash, which the applet and the
+ *         application can write.
  *	\param[in, out] uint8_t* io_key
  *  \return ATCA_STATUS
  */
@@ -63,11 +67,15 @@ ATCA_STATUS io_protection_get_key(uint8_t* io_key)
 ATCA_STATUS io_protection_set_key(uint8_t* io_key)
 {
 	ATCA_STATUS status = ATCA_SUCCESS;
+	uint8_t page[NVMCTRL_PAGE_SIZE];
 
 	enum status_code nvm_status;
 
-	/*First ATCA_KEY_SIZE bytes contains Key and rest is loaded from ram/stack */
-	nvm_status = nvm_write_buffer(IO_PROTECTION_PAGE_ADDRESS, io_key, NVMCTRL_PAGE_SIZE);
+	/*Rest of the page is left erased */
+	memset(page, 0xFF, sizeof(page));
+	memcpy(page, io_key, ATCA_KEY_SIZE);
+	nvm_status = nvm_write_buffer(IO_PROTECTION_PAGE_ADDRESS, page, NVMCTRL_PAGE_SIZE);
+	memset(page, 0xFF, sizeof(page));
 	if(nvm_status != STATUS_OK)
 	{
 		status = ATCA_GEN_FAIL;
@@ -68,17 +68,49 @@
 #include "sam_ba_monitor.h"
 #include "usart_sam_ba.h"
 #include "crypto_device_app.h"
-#include "adc_feature.h"
+#include "boot_trace.h"
+#include "boot_handoff.h"
+#include "boot_clock.h"
+#include "secure_boot_slot.h"
 
 
-struct adc_module adc_instance;
-struct adc_config config_adc;
-uint16_t calculate_adc(enum adc_positive_input adc_input);
-void random_seed_init(void);
-void configure_adc(void);
-
 static void check_start_application(void);
 
+/**
+ * \brief A watchdog or software reset may skip the verification if the
+ *        handoff block of the previous boot is still valid
+ */
+static bool check_warm_reset(void)
+{
+#if BOOT_HANDOFF_WARM_RESET_ENABLED
+	enum system_reset_cause reset_cause = system_get_reset_cause();
+
+	if ((reset_cause == SYSTEM_RESET_CAUSE_WDT) || (reset_cause == SYSTEM_RESET_CAUSE_SOFTWARE)) {
+		if (boot_handoff_resume() == ATCA_SUCCESS) {
+			return true;
+		}
+		/* The resume may have selected the slot of the block */
+		secure_boot_slot_select_first();
+	}
+#endif
+	return false;
+}
+
+/**
+ * \brief Verify the application with the core on the boost clock, the
+ *        configured clock tree is back on return
+ */
+static ATCA_STATUS verify_application(void)
+{
+	ATCA_STATUS status;
+
+	boot_clock_boost();
+	status = crypto_device_verify_app();
+	boot_clock_restore();
+
+	return status;
+}
+
 #ifdef CONF_USBCDC_INTERFACE_SUPPORT
 static volatile bool main_b_cdc_enable = false;
 #endif
@@ -89,19 +121,18 @@ static volatile bool main_b_cdc_enable = false;
 static void check_start_application(void)
 {
 	uint32_t app_start_address;
-
-	/* Load the Reset Handler address of the application */
-	app_start_address = *(uint32_t *)(APP_START_ADDRESS + 4);
+	uint32_t app_vectors;
 
 	/**
-	 * Test reset vector of application @APP_START_ADDRESS+4
-	 * Stay in SAM-BA if *(APP_START+0x4) == 0xFFFFFFFF
+	 * Select the slot with the newest image, the other slot is the fallback.
+	 * Stay in SAM-BA if the reset vector of both slots is 0xFFFFFFFF
 	 * Application erased condition
 	 */
-	if (app_start_address == 0xFFFFFFFF) {
+	if (!secure_boot_slot_select_first()) {
 		/* Stay in bootloader */
 		return;
 	}
+	BOOT_TRACE(BOOT_TRACE_SLOT_SELECTED, secure_boot_slot_selected());
 
 	volatile PortGroup *boot_port = (volatile PortGroup *)(&(PORT->Group[BOOT_LOAD_PIN / 32]));
 	volatile bool boot_en;
@@ -119,17 +150,26 @@ static void check_start_application(void)
 		return;
 	}
 
-	if(crypto_device_verify_app() != ATCA_SUCCESS)
+	if(!check_warm_reset() && (verify_application() != ATCA_SUCCESS))
 	{
 		/* Stay in bootloader */
 		return;
 	}
 
+	/* Load the Reset Handler address of the slot verified or resumed, it
+	 * executes in place */
+	app_vectors = secure_boot_slot_start_address();
+	app_start_address = *(uint32_t *)(app_vectors + 4);
+
+	/* Hand SysTick over to the application, the trace stays in RAM */
+	BOOT_TRACE(BOOT_TRACE_JUMP_APPLICATION, app_start_address);
+	BOOT_TRACE_STOP();
+
 	/* Rebase the Stack Pointer */
-	__set_MSP(*(uint32_t *) APP_START_ADDRESS);
+	__set_MSP(*(uint32_t *) app_vectors);
 
 	/* Rebase the vector table base address */
-	SCB->VTOR = ((uint32_t) APP_START_ADDRESS & SCB_VTOR_TBLOFF_Msk);
+	SCB->VTOR = (app_vectors & SCB_VTOR_TBLOFF_Msk);
 
 	/* Jump to application Reset Handler in the application */
 	asm("bx %0"::"r"(app_start_address));
@@ -139,55 +179,6 @@ static void check_start_application(void)
 
 
 
-uint16_t calculate_adc(enum adc_positive_input adc_input)
-{
-	uint16_t result;
-
-	
-	adc_set_positive_input(&adc_instance,adc_input);
-	adc_start_conversion(&adc_instance);
-	do {
-		/* Wait for conversion to be done and read out result */
-	} while (adc_read(&adc_instance, &result) == STATUS_BUSY);
-	adc_flush(&adc_instance);
-	return result;
-	
-}
-
-void configure_adc(void)
-{
-	system_voltage_reference_enable(SYSTEM_VOLTAGE_REFERENCE_TEMPSENSE);
-	adc_get_config_defaults(&config_adc);
-	config_adc.resolution =  ADC_CTRLB_RESSEL_16BIT;
-
-	adc_init(&adc_instance, ADC, &config_adc);
-	
-	adc_enable(&adc_instance);
-	
-}
-
-void random_seed_init(void)
-{
-	uint16_t result;
-	uint32_t rand_seed=0;
-	configure_adc();
-	result=calculate_adc(ADC_POSITIVE_INPUT_TEMP);
-	rand_seed |= (uint32_t)(result & 0x00FF)<<0 ;
-	
-	result=calculate_adc(ADC_POSITIVE_INPUT_SCALEDCOREVCC);
-	rand_seed |= (uint32_t)(result & 0x00FF)<<8 ;
-	
-	result=calculate_adc(ADC_POSITIVE_INPUT_SCALEDIOVCC);
-	rand_seed |=(uint32_t) (result & 0x00FF)<<16 ;
-	
-	result=calculate_adc(ADC_POSITIVE_INPUT_BANDGAP);
-	rand_seed |= (uint32_t)(result & 0x00FF)<<24 ;
-
-	
-	srand(rand_seed);
-	
-}
-
 #if DEBUG_ENABLE
 #	define DEBUG_PIN_HIGH 	port_pin_set_output_level(BOOT_LED, 1)
 #	define DEBUG_PIN_LOW 	port_pin_set_output_level(BOOT_LED, 0)
@@ -203,17 +194,24 @@ void random_seed_init(void)
 int main(void)
 {
 	DEBUG_PIN_HIGH;
+
+	/* Start timing the boot phases */
+	BOOT_TRACE_START();
+
+	/* The application must not see the handoff block of a previous boot */
+	boot_handoff_begin();
 	
 	/* We have determined we should stay in the monitor. */
 	/* System initialization */
 	system_init();
+	BOOT_TRACE(BOOT_TRACE_SYSTEM_INIT_DONE, 0);
 	
-    /* Update the seed value for use with rand() */
-	random_seed_init();
-
 	/* Jump in application if condition is satisfied */
 	check_start_application();
 
+	BOOT_TRACE(BOOT_TRACE_MONITOR_START, 0);
+	BOOT_TRACE_STOP();
+
 #ifdef CONF_USBCDC_INTERFACE_SUPPORT
 	/* Start USB stack */
 	udc_start();
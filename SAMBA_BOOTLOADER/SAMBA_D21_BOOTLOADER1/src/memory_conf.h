@@ -42,6 +42,24 @@ extern "C" {
 #define USER_APPLICATION_END_ADDRESS		(USER_APPLICATION_START_ADDRESS + (24*1024))
 #define USER_APPLICATION_HEADER_SIZE		(2 * NVMCTRL_PAGE_SIZE)
 #define USER_APPLICATION_HEADER_ADDRESS		(USER_APPLICATION_END_ADDRESS - USER_APPLICATION_HEADER_SIZE)
+/* Footer bytes covered by the signature, everything before the signature */
+#define USER_APPLICATION_FOOTER_SIGNED_SIZE	NVMCTRL_PAGE_SIZE
+
+/* Pair of rows after the former update marker row (no longer written, the
+ * marker is kept here) holding the boot state journal, see boot_journal.c */
+#define BOOT_JOURNAL_ADDRESS				(USER_APPLICATION_END_ADDRESS + NVMCTRL_ROW_SIZE)
+#define BOOT_JOURNAL_ROW_COUNT				2
+
+/* Second application slot, the same size and footer layout as the first one.
+ * An image is linked for the slot it executes from, see secure_boot_slot.c */
+#define USER_APPLICATION_SLOT_SIZE			(USER_APPLICATION_END_ADDRESS - USER_APPLICATION_START_ADDRESS)
+#define USER_APPLICATION_SLOT_B_ADDRESS		0x00010000
+#define USER_APPLICATION_SLOT_COUNT			2
+
+/* Flash after the second slot that can hold partitions signed with the
+ * application, see secure_boot_partition.c */
+#define SECURE_BOOT_PARTITION_START_ADDRESS	(USER_APPLICATION_SLOT_B_ADDRESS + USER_APPLICATION_SLOT_SIZE)
+#define SECURE_BOOT_PARTITION_END_ADDRESS	FLASH_SIZE
 
 #ifdef __cplusplus
 }
@@ -49,6 +49,8 @@
 #include "sam_ba_monitor.h"
 #include "usart_sam_ba.h"
 #include "conf_board.h"
+#include "boot_trace.h"
+#include "crypto_device_poll.h"
 
 const char RomBOOT_Version[] = SAM_BA_VERSION;
 
@@ -154,6 +156,88 @@ void sam_ba_putdata_term(uint8_t* data, uint32_t length)
 	return;
 }
 
+#if BOOT_TRACE_ENABLED
+/**
+ * \brief Send the boot phase trace recorded before the monitor started
+ *
+ * In binary mode the raw boot_trace_buffer is sent. In terminal mode the
+ * boot count and number of records are followed by one line per record,
+ * oldest first: timestamp in microseconds, phase and argument.
+ */
+static void sam_ba_send_boot_trace(void)
+{
+	const boot_trace_buffer *trace = boot_trace_get();
+	const boot_trace_entry *entry;
+	uint32_t value, entries, index;
+
+	if (!b_terminal_mode)
+	{
+		ptr_monitor_if->putdata(trace, sizeof(*trace));
+		return;
+	}
+
+	value = trace->boot_count;
+	sam_ba_putdata_term((uint8_t*) &value, 4);
+	value = trace->count;
+	sam_ba_putdata_term((uint8_t*) &value, 2);
+
+	entries = min(trace->count, BOOT_TRACE_ENTRIES);
+	index = (trace->head + BOOT_TRACE_ENTRIES - entries) % BOOT_TRACE_ENTRIES;
+	while (entries--)
+	{
+		entry = &trace->entries[index];
+		value = entry->timestamp_us;
+		sam_ba_putdata_term((uint8_t*) &value, 4);
+		value = entry->phase;
+		sam_ba_putdata_term((uint8_t*) &value, 2);
+		value = entry->arg;
+		sam_ba_putdata_term((uint8_t*) &value, 2);
+		index = (index + 1) % BOOT_TRACE_ENTRIES;
+	}
+}
+#endif
+
+/**
+ * \brief Send the ATECC608A command latencies learned by the I2C HAL
+ *
+ * In binary mode the raw crypto_device_poll_entry table is sent. In terminal
+ * mode the number of entries is followed by one line per field: opcode,
+ * variant, completions, polls, timeouts, estimate, minimum and maximum
+ * latency in microseconds.
+ */
+static void sam_ba_send_poll_table(void)
+{
+	const crypto_device_poll_entry *entry;
+	uint8_t count;
+	uint32_t value;
+
+	entry = crypto_device_poll_table(&count);
+	if (!b_terminal_mode)
+	{
+		ptr_monitor_if->putdata(entry, count * sizeof(*entry));
+		return;
+	}
+
+	value = count;
+	sam_ba_putdata_term((uint8_t*) &value, 1);
+	for (; count > 0; count--, entry++)
+	{
+		value = entry->opcode;
+		sam_ba_putdata_term((uint8_t*) &value, 1);
+		value = entry->variant;
+		sam_ba_putdata_term((uint8_t*) &value, 1);
+		value = entry->completions;
+		sam_ba_putdata_term((uint8_t*) &value, 2);
+		value = entry->polls;
+		sam_ba_putdata_term((uint8_t*) &value, 2);
+		value = entry->timeouts;
+		sam_ba_putdata_term((uint8_t*) &value, 2);
+		sam_ba_putdata_term((uint8_t*) &entry->estimate_us, 4);
+		sam_ba_putdata_term((uint8_t*) &entry->min_seen_us, 4);
+		sam_ba_putdata_term((uint8_t*) &entry->max_seen_us, 4);
+	}
+}
+
 volatile uint32_t sp;
 /**
  * \brief Execute an applet from the specified address
@@ -306,6 +390,16 @@ void sam_ba_monitor_run(void)
 						ptr_monitor_if->putdata((uint8_t *) &(__TIME__), i);
 						ptr_monitor_if->putdata("\n\r", 2);
 					}
+#if BOOT_TRACE_ENABLED
+					else if (command == 'P')
+					{
+						sam_ba_send_boot_trace();
+					}
+#endif
+					else if (command == 'L')
+					{
+						sam_ba_send_poll_table();
+					}
 
 					command = 'z';
 					current_number = 0;
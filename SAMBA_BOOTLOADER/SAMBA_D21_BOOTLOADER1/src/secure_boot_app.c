@@ -0,0 +1,552 @@
+/**
+ * \file
+ *
+ * \brief Bootloader secure boot sequence over the memory mapped application.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <string.h>
+#include "cryptoauthlib.h"
+#include "secure_boot.h"
+#include "secure_boot_memory.h"
+#include "io_protection_key.h"
+#include "secure_boot_app.h"
+#include "secure_boot_drbg.h"
+#include "boot_handoff.h"
+#include "boot_trace.h"
+
+/*
+ * Same sequence as secure_boot_process() in CryptoAuthLib, except that the
+ * application digest is computed straight over memory mapped flash. The
+ * image is hashed in one pass with no intermediate RAM buffer.
+ *
+ * With SECURE_BOOT_PIPELINE_ENABLED the digest is started before the device
+ * is probed and advanced from the HAL delays (wake delay, command execution
+ * and polling waits), so device latency is spent hashing rather than
+ * spinning. Whatever is left is hashed before the SecureBoot command.
+ *
+ * The digest is computed by one of the engines below, in software or by the
+ * device SHA command. The faster one depends on the core and I2C clocks, it
+ * is timed on a sample of the image after the first successful verification
+ * and cached by crypto_device_app.c for the following boots. Only the host
+ * engine runs in the background, the device engine needs the bus.
+ */
+
+/** Bytes hashed per background step, one SHA-256 block */
+#define SECURE_BOOT_PIPELINE_STEP_SIZE      64
+/** Assumed cost of a step until the first one has been measured */
+#define SECURE_BOOT_PIPELINE_FIRST_STEP_US  1000
+/** Bytes from the start of the image used to time the digest engines */
+#define SECURE_BOOT_DIGEST_CALIBRATION_SIZE 1024
+
+/** \brief State of the engine computing a digest */
+typedef union
+{
+    atcac_sha2_256_ctx host;
+    struct
+    {
+        uint8_t block[ATCA_SHA256_BLOCK_SIZE];  /**< Partial block not sent yet */
+        uint8_t length;
+    } device;
+} secure_boot_digest_ctx;
+
+/** \brief Digest engine interface */
+typedef struct
+{
+    ATCA_STATUS (*init)(secure_boot_digest_ctx* ctx);
+    ATCA_STATUS (*update)(secure_boot_digest_ctx* ctx, const uint8_t* data, uint32_t length);
+    ATCA_STATUS (*finish)(secure_boot_digest_ctx* ctx, uint8_t* digest);
+} secure_boot_digest_engine;
+
+static ATCA_STATUS secure_boot_host_sha_init(secure_boot_digest_ctx* ctx)
+{
+    atcac_sw_sha2_256_init(&ctx->host);
+    return ATCA_SUCCESS;
+}
+
+static ATCA_STATUS secure_boot_host_sha_update(secure_boot_digest_ctx* ctx, const uint8_t* data, uint32_t length)
+{
+    atcac_sw_sha2_256_update(&ctx->host, data, length);
+    return ATCA_SUCCESS;
+}
+
+static ATCA_STATUS secure_boot_host_sha_finish(secure_boot_digest_ctx* ctx, uint8_t* digest)
+{
+    atcac_sw_sha2_256_finish(&ctx->host, digest);
+    return ATCA_SUCCESS;
+}
+
+static ATCA_STATUS secure_boot_device_sha_init(secure_boot_digest_ctx* ctx)
+{
+    ctx->device.length = 0;
+    return atcab_sha_start();
+}
+
+/** \brief Streams whole blocks to the device, flash is sent in place */
+static ATCA_STATUS secure_boot_device_sha_update(secure_boot_digest_ctx* ctx, const uint8_t* data, uint32_t length)
+{
+    ATCA_STATUS status = ATCA_SUCCESS;
+    uint32_t copy_length;
+
+    while ((status == ATCA_SUCCESS) && (length > 0))
+    {
+        if ((ctx->device.length == 0) && (length >= ATCA_SHA256_BLOCK_SIZE))
+        {
+            status = atcab_sha_update(data);
+            data += ATCA_SHA256_BLOCK_SIZE;
+            length -= ATCA_SHA256_BLOCK_SIZE;
+            continue;
+        }
+
+        copy_length = ATCA_SHA256_BLOCK_SIZE - ctx->device.length;
+        if (copy_length > length)
+        {
+            copy_length = length;
+        }
+        memcpy(&ctx->device.block[ctx->device.length], data, copy_length);
+        ctx->device.length += copy_length;
+        data += copy_length;
+        length -= copy_length;
+
+        if (ctx->device.length == ATCA_SHA256_BLOCK_SIZE)
+        {
+            status = atcab_sha_update(ctx->device.block);
+            ctx->device.length = 0;
+        }
+    }
+
+    return status;
+}
+
+static ATCA_STATUS secure_boot_device_sha_finish(secure_boot_digest_ctx* ctx, uint8_t* digest)
+{
+    return atcab_sha_end(digest, ctx->device.length, ctx->device.block);
+}
+
+static const secure_boot_digest_engine secure_boot_digest_engines[] =
+{
+    [SECURE_BOOT_DIGEST_ENGINE_HOST] = { secure_boot_host_sha_init, secure_boot_host_sha_update, secure_boot_host_sha_finish },
+    [SECURE_BOOT_DIGEST_ENGINE_DEVICE] = { secure_boot_device_sha_init, secure_boot_device_sha_update, secure_boot_device_sha_finish },
+};
+
+/** \brief Application digest in progress */
+static struct
+{
+    bool active;                        /**< Digest started, background steps allowed */
+    bool step_measured;
+    secure_boot_digest_engine_id engine_id;     /**< Engine requested for this boot */
+    memory_parameters memory_params;    /**< Footer of the image being hashed */
+    const secure_boot_digest_engine* engine;
+    secure_boot_digest_ctx ctx;
+    uint32_t remaining;                 /**< Bytes still to hash */
+    uint32_t step_us;                   /**< Longest step seen, a step only starts if it fits the delay */
+} secure_boot_digest;
+
+/** \brief Selects the digest engine, SECURE_BOOT_DIGEST_ENGINE_UNKNOWN hashes
+ *         on the host and calibrates the engines once the image is verified.
+ *  \param[in] secure_boot_digest_engine_id engine_id Engine cached for this device
+ */
+void secure_boot_app_set_digest_engine(secure_boot_digest_engine_id engine_id)
+{
+    #if SECURE_BOOT_DIGEST_DEVICE_ENABLED
+    if (engine_id > SECURE_BOOT_DIGEST_ENGINE_DEVICE)
+    {
+        engine_id = SECURE_BOOT_DIGEST_ENGINE_UNKNOWN;
+    }
+    #else
+    engine_id = SECURE_BOOT_DIGEST_ENGINE_HOST;
+    #endif
+    secure_boot_digest.engine_id = engine_id;
+}
+
+/** \brief Returns the digest engine for the next boot, calibrated if it was unknown */
+secure_boot_digest_engine_id secure_boot_app_get_digest_engine(void)
+{
+    return secure_boot_digest.engine_id;
+}
+
+/** \brief Starts the digest of the image described by secure_boot_digest.memory_params
+ *  \return ATCA_SUCCESS on success, otherwise an error code.
+ */
+static ATCA_STATUS secure_boot_app_begin_digest(void)
+{
+    ATCA_STATUS status;
+
+    secure_boot_digest.engine = &secure_boot_digest_engines[SECURE_BOOT_DIGEST_ENGINE_HOST];
+    if (secure_boot_digest.engine_id == SECURE_BOOT_DIGEST_ENGINE_DEVICE)
+    {
+        secure_boot_digest.engine = &secure_boot_digest_engines[SECURE_BOOT_DIGEST_ENGINE_DEVICE];
+    }
+    if ((status = secure_boot_digest.engine->init(&secure_boot_digest.ctx)) != ATCA_SUCCESS)
+    {
+        return status;
+    }
+
+    secure_boot_digest.remaining = secure_boot_digest.memory_params.memory_size;
+    secure_boot_digest.step_us = SECURE_BOOT_PIPELINE_FIRST_STEP_US;
+    secure_boot_digest.step_measured = false;
+    secure_boot_digest.active = true;
+
+    return ATCA_SUCCESS;
+}
+
+/** \brief Hashes up to length bytes of the remaining image
+ *  \return ATCA_SUCCESS on success, otherwise an error code.
+ */
+static ATCA_STATUS secure_boot_app_hash(uint32_t length)
+{
+    ATCA_STATUS status;
+    const uint8_t* data;
+
+    if ((status = secure_boot_map_memory(&data, &length)) == ATCA_SUCCESS)
+    {
+        status = secure_boot_digest.engine->update(&secure_boot_digest.ctx, data, length);
+        secure_boot_digest.remaining -= length;
+    }
+
+    return status;
+}
+
+/** \brief Hashes the rest of the image and returns the application digest
+ *  \param[out] uint8_t* digest Application digest
+ *  \return ATCA_SUCCESS on success, otherwise an error code.
+ */
+static ATCA_STATUS secure_boot_app_end_digest(uint8_t* digest)
+{
+    ATCA_STATUS status = ATCA_SUCCESS;
+
+    secure_boot_digest.active = false;
+    while ((status == ATCA_SUCCESS) && (secure_boot_digest.remaining > 0))
+    {
+        status = secure_boot_app_hash(secure_boot_digest.remaining);
+    }
+
+    if (status == ATCA_SUCCESS)
+    {
+        status = secure_boot_digest.engine->finish(&secure_boot_digest.ctx, digest);
+    }
+
+    return status;
+}
+
+#if SECURE_BOOT_DIGEST_DEVICE_ENABLED
+/** \brief Times a digest engine over the calibration sample
+ *  \param[in] secure_boot_digest_engine_id engine_id Engine to time
+ *  \param[out] uint32_t* elapsed_us Time taken
+ *  \return ATCA_SUCCESS on success, otherwise an error code.
+ */
+static ATCA_STATUS secure_boot_app_time_engine(secure_boot_digest_engine_id engine_id, uint32_t* elapsed_us)
+{
+    ATCA_STATUS status;
+    const secure_boot_digest_engine* engine = &secure_boot_digest_engines[engine_id];
+    const uint8_t* data;
+    uint32_t length = SECURE_BOOT_DIGEST_CALIBRATION_SIZE;
+    uint8_t digest[ATCA_SHA_DIGEST_SIZE];
+    uint32_t start_us;
+
+    do
+    {
+        if ((status = secure_boot_sample_memory(&data, &length)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+
+        start_us = secure_boot_app_clock_us();
+        if ((status = engine->init(&secure_boot_digest.ctx)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+        if ((status = engine->update(&secure_boot_digest.ctx, data, length)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+        if ((status = engine->finish(&secure_boot_digest.ctx, digest)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+        *elapsed_us = secure_boot_app_clock_us() - start_us;
+    }
+    while (0);
+
+    return status;
+}
+
+/** \brief Selects the faster digest engine for the next boots. The host engine
+ *         is kept if the device engine fails. Runs after the digest is done,
+ *         its context is reused.
+ */
+static void secure_boot_app_calibrate_digest(void)
+{
+    uint32_t host_us;
+    uint32_t device_us;
+
+    secure_boot_app_clock_start();
+    secure_boot_digest.engine_id = SECURE_BOOT_DIGEST_ENGINE_HOST;
+    if ((secure_boot_app_time_engine(SECURE_BOOT_DIGEST_ENGINE_HOST, &host_us) == ATCA_SUCCESS) &&
+        (secure_boot_app_time_engine(SECURE_BOOT_DIGEST_ENGINE_DEVICE, &device_us) == ATCA_SUCCESS) &&
+        (device_us < host_us))
+    {
+        secure_boot_digest.engine_id = SECURE_BOOT_DIGEST_ENGINE_DEVICE;
+    }
+    #if !SECURE_BOOT_PIPELINE_ENABLED
+    secure_boot_app_clock_stop();
+    #endif
+}
+#endif
+
+/** \brief Starts hashing the application ahead of the device traffic. Only
+ *         done once the IO protection key is bound, binding needs the device.
+ *  \return ATCA_SUCCESS if the digest is running in the background
+ */
+ATCA_STATUS secure_boot_app_start(void)
+{
+    ATCA_STATUS status = ATCA_GEN_FAIL;
+    #if SECURE_BOOT_PIPELINE_ENABLED
+    uint8_t io_key[ATCA_KEY_SIZE];
+    uint8_t io_key_unbound[ATCA_KEY_SIZE];
+
+    do
+    {
+        if ((status = io_protection_get_key(io_key)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+
+        memset(io_key_unbound, 0xFF, sizeof(io_key_unbound));
+        status = (memcmp(io_key, io_key_unbound, sizeof(io_key)) == 0) ? ATCA_GEN_FAIL : ATCA_SUCCESS;
+        memset(io_key, 0xFF, sizeof(io_key));
+        if (status != ATCA_SUCCESS)
+        {
+            break;
+        }
+
+        /*The device engine is not run in the background */
+        if (secure_boot_digest.engine_id == SECURE_BOOT_DIGEST_ENGINE_DEVICE)
+        {
+            status = ATCA_GEN_FAIL;
+            break;
+        }
+
+        if ((status = secure_boot_init_memory(&secure_boot_digest.memory_params)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+
+        secure_boot_app_clock_start();
+        if ((status = secure_boot_app_begin_digest()) != ATCA_SUCCESS)
+        {
+            secure_boot_deinit_memory(&secure_boot_digest.memory_params);
+            secure_boot_app_clock_stop();
+        }
+    }
+    while (0);
+    #endif
+
+    return status;
+}
+
+/** \brief Stops background hashing, the digest is abandoned if not finished */
+void secure_boot_app_stop(void)
+{
+    #if SECURE_BOOT_PIPELINE_ENABLED
+    if (secure_boot_digest.active)
+    {
+        secure_boot_digest.active = false;
+        secure_boot_deinit_memory(&secure_boot_digest.memory_params);
+    }
+    secure_boot_app_clock_stop();
+    #endif
+}
+
+/** \brief Advances the background digest from a HAL delay
+ *  \param[in] uint32_t budget_us Delay requested by the caller
+ *  \return Microseconds spent, the caller waits out the rest of the delay
+ */
+uint32_t secure_boot_app_background(uint32_t budget_us)
+{
+    uint32_t start_us;
+    uint32_t last_us;
+    uint32_t now_us;
+    uint32_t used_us = 0;
+
+    if (!secure_boot_digest.active || (secure_boot_digest.remaining == 0) ||
+        (secure_boot_digest.engine != &secure_boot_digest_engines[SECURE_BOOT_DIGEST_ENGINE_HOST]))
+    {
+        return 0;
+    }
+
+    start_us = last_us = secure_boot_app_clock_us();
+    while ((secure_boot_digest.remaining > 0) && ((used_us + secure_boot_digest.step_us) <= budget_us))
+    {
+        if (secure_boot_app_hash(SECURE_BOOT_PIPELINE_STEP_SIZE) != ATCA_SUCCESS)
+        {
+            /*Retried and reported by secure_boot_app_end_digest() */
+            secure_boot_digest.active = false;
+            break;
+        }
+
+        now_us = secure_boot_app_clock_us();
+        if (!secure_boot_digest.step_measured || ((now_us - last_us) > secure_boot_digest.step_us))
+        {
+            secure_boot_digest.step_us = now_us - last_us;
+            secure_boot_digest.step_measured = true;
+        }
+        last_us = now_us;
+        used_us = now_us - start_us;
+    }
+
+    return used_us;
+}
+
+/** \brief Verifies the application against the signature in its footer using
+ *         the secure boot mode configured in the device.
+ *  \return ATCA_SUCCESS on success, otherwise an error code.
+ */
+ATCA_STATUS secure_boot_app_process(void)
+{
+    ATCA_STATUS status;
+    memory_parameters* memory_params = &secure_boot_digest.memory_params;
+    uint8_t digest[ATCA_SHA_DIGEST_SIZE];
+    uint8_t secure_boot_config;
+    uint8_t secure_boot_mode;
+    const uint8_t* signature;
+    #if SECURE_BOOT_DIGEST_ENCRYPT_ENABLED
+    uint8_t randomnum[NONCE_NUMIN_SIZE];
+    uint8_t io_key[ATCA_KEY_SIZE];
+    bool is_verified = false;
+    #endif
+
+    do
+    {
+        if (!secure_boot_digest.active)
+        {
+            /*Initialize IO protection and memory, reads the footer */
+            memset(memory_params, 0, sizeof(*memory_params));
+            if ((status = secure_boot_init_memory(memory_params)) != ATCA_SUCCESS)
+            {
+                break;
+            }
+            if ((status = secure_boot_app_begin_digest()) != ATCA_SUCCESS)
+            {
+                break;
+            }
+        }
+
+        if ((status = atcab_read_bytes_zone(ATCA_ZONE_CONFIG, 0, SECUREBOOTCONFIG_OFFSET, &secure_boot_config, sizeof(secure_boot_config))) != ATCA_SUCCESS)
+        {
+            break;
+        }
+
+        if ((status = secure_boot_app_end_digest(digest)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+
+        /*Select SecureBoot command mode, signature is only sent when the device needs it */
+        secure_boot_mode = SECUREBOOT_MODE_FULL;
+        signature = NULL;
+        switch (secure_boot_config & SECUREBOOTCONFIG_MODE_MASK)
+        {
+        case SECUREBOOTCONFIG_MODE_FULL_BOTH:
+            signature = memory_params->signature;
+            break;
+
+        case SECUREBOOTCONFIG_MODE_FULL_SIG:
+            break;
+
+        case SECUREBOOTCONFIG_MODE_FULL_DIG:
+            #if SECURE_BOOT_UPGRADE_SUPPORT
+            if (!secure_boot_check_full_copy_completion())
+            {
+                /*New image, verify signature and store its digest */
+                secure_boot_mode = SECUREBOOT_MODE_FULL_COPY;
+                signature = memory_params->signature;
+            }
+            #endif
+            break;
+
+        default:
+            status = ATCA_GEN_FAIL;
+            break;
+        }
+        if (status != ATCA_SUCCESS)
+        {
+            break;
+        }
+
+        #if SECURE_BOOT_DIGEST_ENCRYPT_ENABLED
+        if ((status = io_protection_get_key(io_key)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+        if ((status = host_generate_random_number(randomnum)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+
+        status = atcab_secureboot_mac(secure_boot_mode, digest, signature, randomnum, io_key, &is_verified);
+        memset(io_key, 0xFF, sizeof(io_key));
+        if ((status == ATCA_SUCCESS) && !is_verified)
+        {
+            status = ATCA_CHECKMAC_VERIFY_FAILED;
+        }
+        #else
+        status = atcab_secureboot(secure_boot_mode, 0, digest, signature, NULL);
+        #endif
+        if (status != ATCA_SUCCESS)
+        {
+            break;
+        }
+
+        if (secure_boot_mode == SECUREBOOT_MODE_FULL_COPY)
+        {
+            /*Later boots only need the digest compare */
+            if ((status = secure_boot_mark_full_copy_completion()) != ATCA_SUCCESS)
+            {
+                break;
+            }
+        }
+
+        /*Tell the application what was verified, it does not hash itself again */
+        boot_handoff_publish(secure_boot_mode, memory_params, BOOT_HANDOFF_DIGEST_SHA256, digest);
+
+        #if SECURE_BOOT_DIGEST_DEVICE_ENABLED
+        if (secure_boot_digest.engine_id == SECURE_BOOT_DIGEST_ENGINE_UNKNOWN)
+        {
+            secure_boot_app_calibrate_digest();
+        }
+        #endif
+    }
+    while (0);
+
+    secure_boot_digest.active = false;
+    secure_boot_drbg_clear();
+    secure_boot_deinit_memory(memory_params);
+    #if SECURE_BOOT_PIPELINE_ENABLED
+    secure_boot_app_clock_stop();
+    #endif
+
+    return status;
+}
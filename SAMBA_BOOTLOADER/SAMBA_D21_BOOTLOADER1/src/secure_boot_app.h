@@ -0,0 +1,82 @@
+/**
+ * \file
+ *
+ * \brief Bootloader secure boot sequence over the memory mapped application.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef SECURE_BOOT_APP_H
+#define SECURE_BOOT_APP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "atca_status.h"
+#include "secure_boot.h"
+
+/** Hash the application during device delays, see secure_boot_app_background() */
+#ifndef SECURE_BOOT_PIPELINE_ENABLED
+#define SECURE_BOOT_PIPELINE_ENABLED    true
+#endif
+
+/** Allow the ATECC608A SHA command as digest engine. The device returns the
+ *  digest over I2C, which IO protection does not cover, so it is off when the
+ *  bus is not trusted. */
+#ifndef SECURE_BOOT_DIGEST_DEVICE_ENABLED
+#define SECURE_BOOT_DIGEST_DEVICE_ENABLED   !SECURE_BOOT_DIGEST_ENCRYPT_ENABLED
+#endif
+
+/** \brief Digest engines, values are stored in the device cache */
+typedef enum
+{
+    SECURE_BOOT_DIGEST_ENGINE_UNKNOWN = 0,  /**< Not calibrated yet */
+    SECURE_BOOT_DIGEST_ENGINE_HOST,         /**< Software SHA-256 */
+    SECURE_BOOT_DIGEST_ENGINE_DEVICE        /**< ATECC608A SHA command */
+} secure_boot_digest_engine_id;
+
+void secure_boot_app_set_digest_engine(secure_boot_digest_engine_id engine_id);
+secure_boot_digest_engine_id secure_boot_app_get_digest_engine(void);
+ATCA_STATUS secure_boot_app_start(void);
+uint32_t secure_boot_app_background(uint32_t budget_us);
+void secure_boot_app_stop(void);
+ATCA_STATUS secure_boot_app_process(void);
+
+/* Free running microsecond clock for the background digest, implemented
+ * next to the delay routines in the timer HAL */
+void secure_boot_app_clock_start(void);
+uint32_t secure_boot_app_clock_us(void);
+void secure_boot_app_clock_stop(void);
+
+/* Memory interface extensions implemented in secure_boot_memory.c */
+ATCA_STATUS secure_boot_map_memory(const uint8_t** data, uint32_t* target_length);
+ATCA_STATUS secure_boot_sample_memory(const uint8_t** data, uint32_t* target_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * \file
+ *
+ * \brief HMAC-DRBG (NIST SP 800-90A, SHA-256) for host nonces.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "cryptoauthlib.h"
+#include "io_protection_key.h"
+#include "secure_boot_hmac.h"
+#include "secure_boot_drbg.h"
+#include "boot_journal.h"
+#include "boot_trace.h"
+
+/** \brief One piece of the data fed to the DRBG update function */
+typedef struct
+{
+    const uint8_t* data;
+    size_t length;
+} secure_boot_drbg_input;
+
+static struct
+{
+    uint8_t key[SECURE_BOOT_HMAC_KEY_SIZE];
+    uint8_t value[SECURE_BOOT_HMAC_SIZE];
+    uint32_t reseed_counter;
+    bool seeded;
+} secure_boot_drbg;
+
+/** \brief HMAC_DRBG_Update(), the provided data is the concatenation of inputs */
+static void secure_boot_drbg_update(const secure_boot_drbg_input* inputs, uint8_t input_count)
+{
+    secure_boot_hmac_ctx hmac;
+    uint8_t round;
+    uint8_t i;
+
+    for (round = 0; round < (input_count ? 2 : 1); round++)
+    {
+        secure_boot_hmac_init(&hmac, secure_boot_drbg.key);
+        secure_boot_hmac_update(&hmac, secure_boot_drbg.value, sizeof(secure_boot_drbg.value));
+        secure_boot_hmac_update(&hmac, &round, sizeof(round));
+        for (i = 0; i < input_count; i++)
+        {
+            secure_boot_hmac_update(&hmac, inputs[i].data, inputs[i].length);
+        }
+        secure_boot_hmac_finish(&hmac, secure_boot_drbg.key);
+
+        secure_boot_hmac_init(&hmac, secure_boot_drbg.key);
+        secure_boot_hmac_update(&hmac, secure_boot_drbg.value, sizeof(secure_boot_drbg.value));
+        secure_boot_hmac_finish(&hmac, secure_boot_drbg.value);
+    }
+}
+
+/** \brief Instantiates on first use, reseeds after SECURE_BOOT_DRBG_RESEED_INTERVAL
+ *         requests. The entropy input is the device Random command; the IO
+ *         protection key is mixed in as personalization so that the output
+ *         stays unpredictable to someone who can see or replace the random
+ *         number on the bus. The instantiation nonce is a count kept in the
+ *         boot journal and stored before it is used, so replaying the same
+ *         random number on every boot still gives a new nonce each time.
+ */
+static ATCA_STATUS secure_boot_drbg_seed(void)
+{
+    ATCA_STATUS status;
+    uint8_t entropy[RANDOM_NUM_SIZE];
+    uint8_t io_key[ATCA_KEY_SIZE];
+    uint32_t count = 0;
+    secure_boot_drbg_input inputs[3];
+
+    do
+    {
+        if ((status = atcab_random(entropy)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+        inputs[0].data = entropy;
+        inputs[0].length = sizeof(entropy);
+
+        if (secure_boot_drbg.seeded)
+        {
+            secure_boot_drbg_update(inputs, 1);
+        }
+        else
+        {
+            if ((status = io_protection_get_key(io_key)) != ATCA_SUCCESS)
+            {
+                break;
+            }
+            /* A count that was not stored is never used */
+            boot_journal_read(BOOT_JOURNAL_DRBG_COUNT, &count, sizeof(count));
+            count++;
+            if ((status = boot_journal_write(BOOT_JOURNAL_DRBG_COUNT, &count, sizeof(count))) != ATCA_SUCCESS)
+            {
+                break;
+            }
+            inputs[1].data = (const uint8_t*)&count;
+            inputs[1].length = sizeof(count);
+            inputs[2].data = io_key;
+            inputs[2].length = sizeof(io_key);
+
+            memset(secure_boot_drbg.key, 0x00, sizeof(secure_boot_drbg.key));
+            memset(secure_boot_drbg.value, 0x01, sizeof(secure_boot_drbg.value));
+            secure_boot_drbg_update(inputs, 3);
+            secure_boot_drbg.seeded = true;
+        }
+        secure_boot_drbg.reseed_counter = 1;
+    }
+    while (0);
+
+    memset(entropy, 0, sizeof(entropy));
+    memset(io_key, 0, sizeof(io_key));
+    BOOT_TRACE(BOOT_TRACE_RANDOM_SEED_DONE, status);
+
+    return status;
+}
+
+/** \brief Fills data with random bytes, seeding from the device the first time
+ *  \param[out] data    Random bytes
+ *  \param[in]  length  Number of bytes
+ *  \return ATCA_STATUS
+ */
+ATCA_STATUS secure_boot_drbg_generate(uint8_t* data, size_t length)
+{
+    ATCA_STATUS status = ATCA_SUCCESS;
+    secure_boot_hmac_ctx hmac;
+    size_t chunk;
+
+    do
+    {
+        if (!secure_boot_drbg.seeded || (secure_boot_drbg.reseed_counter > SECURE_BOOT_DRBG_RESEED_INTERVAL))
+        {
+            if ((status = secure_boot_drbg_seed()) != ATCA_SUCCESS)
+            {
+                break;
+            }
+        }
+
+        while (length)
+        {
+            secure_boot_hmac_init(&hmac, secure_boot_drbg.key);
+            secure_boot_hmac_update(&hmac, secure_boot_drbg.value, sizeof(secure_boot_drbg.value));
+            secure_boot_hmac_finish(&hmac, secure_boot_drbg.value);
+
+            chunk = (length < sizeof(secure_boot_drbg.value)) ? length : sizeof(secure_boot_drbg.value);
+            memcpy(data, secure_boot_drbg.value, chunk);
+            data += chunk;
+            length -= chunk;
+        }
+        secure_boot_drbg_update(NULL, 0);
+        secure_boot_drbg.reseed_counter++;
+    }
+    while (0);
+
+    return status;
+}
+
+/** \brief Forgets the DRBG state, the next request seeds from the device again.
+ *         Called before leaving the bootloader, the application gets the SRAM
+ *         as it is. */
+void secure_boot_drbg_clear(void)
+{
+    memset(&secure_boot_drbg, 0, sizeof(secure_boot_drbg));
+}
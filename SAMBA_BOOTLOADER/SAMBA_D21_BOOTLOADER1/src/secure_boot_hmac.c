@@ -0,0 +1,81 @@
+/**
+ * \file
+ *
+ * \brief HMAC-SHA256 over the CryptoAuthLib software SHA-256.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <string.h>
+#include "secure_boot_hmac.h"
+
+#define SECURE_BOOT_HMAC_BLOCK_SIZE     64
+#define SECURE_BOOT_HMAC_IPAD           0x36
+#define SECURE_BOOT_HMAC_OPAD           0x5C
+
+/** \brief Restarts the hash with the padded key */
+static void secure_boot_hmac_pad(secure_boot_hmac_ctx* ctx, uint8_t pad_byte)
+{
+    uint8_t pad[SECURE_BOOT_HMAC_BLOCK_SIZE];
+    uint8_t i;
+
+    memset(pad, pad_byte, sizeof(pad));
+    for (i = 0; i < sizeof(ctx->key); i++)
+    {
+        pad[i] ^= ctx->key[i];
+    }
+    atcac_sw_sha2_256_init(&ctx->sha);
+    atcac_sw_sha2_256_update(&ctx->sha, pad, sizeof(pad));
+    memset(pad, 0, sizeof(pad));
+}
+
+/** \brief Starts an HMAC
+ *  \param[out] ctx HMAC context
+ *  \param[in]  key SECURE_BOOT_HMAC_KEY_SIZE bytes, copied
+ */
+void secure_boot_hmac_init(secure_boot_hmac_ctx* ctx, const uint8_t* key)
+{
+    memcpy(ctx->key, key, sizeof(ctx->key));
+    secure_boot_hmac_pad(ctx, SECURE_BOOT_HMAC_IPAD);
+}
+
+void secure_boot_hmac_update(secure_boot_hmac_ctx* ctx, const void* data, size_t length)
+{
+    atcac_sw_sha2_256_update(&ctx->sha, (const uint8_t*)data, length);
+}
+
+/** \brief Writes the SECURE_BOOT_HMAC_SIZE byte MAC and wipes the context,
+ *         mac may be the key the context was started with.
+ */
+void secure_boot_hmac_finish(secure_boot_hmac_ctx* ctx, uint8_t* mac)
+{
+    uint8_t inner[ATCA_SHA2_256_DIGEST_SIZE];
+
+    atcac_sw_sha2_256_finish(&ctx->sha, inner);
+    secure_boot_hmac_pad(ctx, SECURE_BOOT_HMAC_OPAD);
+    atcac_sw_sha2_256_update(&ctx->sha, inner, sizeof(inner));
+    atcac_sw_sha2_256_finish(&ctx->sha, mac);
+    memset(inner, 0, sizeof(inner));
+    memset(ctx, 0, sizeof(*ctx));
+}
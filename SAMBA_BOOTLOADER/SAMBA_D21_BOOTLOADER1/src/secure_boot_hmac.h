@@ -0,0 +1,60 @@
+/**
+ * \file
+ *
+ * \brief HMAC-SHA256 over the CryptoAuthLib software SHA-256.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef SECURE_BOOT_HMAC_H
+#define SECURE_BOOT_HMAC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "crypto/atca_crypto_sw_sha2.h"
+
+/** Only 32 byte keys are used, the size of the IO protection key */
+#define SECURE_BOOT_HMAC_KEY_SIZE       ATCA_SHA2_256_DIGEST_SIZE
+#define SECURE_BOOT_HMAC_SIZE           ATCA_SHA2_256_DIGEST_SIZE
+
+/** \brief HMAC in progress */
+typedef struct
+{
+    atcac_sha2_256_ctx sha;
+    uint8_t key[SECURE_BOOT_HMAC_KEY_SIZE];
+} secure_boot_hmac_ctx;
+
+void secure_boot_hmac_init(secure_boot_hmac_ctx* ctx, const uint8_t* key);
+void secure_boot_hmac_update(secure_boot_hmac_ctx* ctx, const void* data, size_t length);
+void secure_boot_hmac_finish(secure_boot_hmac_ctx* ctx, uint8_t* mac);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
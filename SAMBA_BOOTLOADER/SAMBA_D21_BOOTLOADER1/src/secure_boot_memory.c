@@ -36,6 +36,12 @@
 #include "secure_boot.h"
 #include "memory_conf.h"
 #include "crypto_device_app.h"
+#include "secure_boot_app.h"
+#include "secure_boot_drbg.h"
+#include "secure_boot_partition.h"
+#include "secure_boot_slot.h"
+#include "boot_journal.h"
+#include "boot_trace.h"
 #include "atca_iface.h"
 #include "hal/atca_hal.h"
 #include "test/atca_test.h"
@@ -48,7 +54,55 @@
 #define USER_APPLICATION_HEADER_ADDRESS		(USER_APPLICATION_END_ADDRESS - USER_APPLICATION_HEADER_SIZE)
 
 
+/** Signature bytes kept in the update marker to identify the image, the R
+ *  component is unique to every signing of every image */
+#define UPDATE_MARKER_SIGNATURE_SIZE		(ATCA_SIG_SIZE / 2)
+
+/** \brief Record appended to the boot journal once FullCopy has stored the
+ *         digest of the image it describes in the device */
+typedef struct
+{
+	uint8_t marker[4];
+	uint32_t version_info;
+	uint8_t signature[UPDATE_MARKER_SIGNATURE_SIZE];
+} update_marker;
+
+/** \brief Flash range read as part of the signed data */
+typedef struct
+{
+	uint32_t start_address;
+	uint32_t end_address;
+} flash_span;
+
+/* The signed data is the image, from the start of the selected slot for the
+ * length given in the footer, then the partitions the footer lists,
+ * then the signed part of the footer. Adjacent ranges are read as one span,
+ * an image that fills the region and has no partitions is a single span. */
 uint32_t flash_read_address;
+static uint32_t flash_read_end_address;
+static uint32_t flash_image_start_address;
+static uint32_t flash_image_end_address;
+static flash_span flash_spans[SECURE_BOOT_PARTITION_MAX + 2];
+static uint8_t flash_span_count;
+/** Span read once the current one is done */
+static uint8_t flash_span_next;
+/** Footer identity of the image being verified, set by secure_boot_init_memory */
+static update_marker footer_marker;
+
+/** \brief Appends a range to the signed data, merged with the previous span if adjacent */
+static void secure_boot_add_span(uint32_t address, uint32_t length)
+{
+	if((flash_span_count > 0) && (flash_spans[flash_span_count - 1].end_address == address))
+	{
+		flash_spans[flash_span_count - 1].end_address += length;
+	}
+	else
+	{
+		flash_spans[flash_span_count].start_address = address;
+		flash_spans[flash_span_count].end_address = address + length;
+		flash_span_count++;
+	}
+}
 
  /** \brief This module takes care of initializing memory access and updates its parameters
  *	\param[in, out] memory_parameters* memory_params pointer to hold memory parameters
@@ -58,6 +112,8 @@ ATCA_STATUS secure_boot_init_memory(memory_parameters* memory_params)
 {
 	ATCA_STATUS status = ATCA_SUCCESS;
 
+	BOOT_TRACE(BOOT_TRACE_MEMORY_INIT, 0);
+
 	do
 	{
 		struct nvm_config config;
@@ -65,14 +121,23 @@ ATCA_STATUS secure_boot_init_memory(memory_parameters* memory_params)
 		uint8_t io_prot_key[ATCA_KEY_SIZE];
 		uint8_t io_prot_no_bond_value[ATCA_KEY_SIZE];
 		uint32_t header_address;
+		uint32_t slot_address;
+		uint32_t slot_header_address;
 		uint8_t* read_data;
 		struct nvm_fusebits fuse_bits;
+		ATCA_STATUS partition_status;
+		const secure_boot_partition_region* regions;
+		uint8_t region_count;
+		uint8_t region_index;
+		uint32_t partition_length;
+
+		flash_span_count = 0;
+		flash_span_next = 0;
 
 		/* Get the default configuration */		
 		nvm_get_config_defaults(&config);
 
-		/* Set wait state to 1 */
-		config.wait_states = 1;
+		/* Keep the wait states of the clock the verification runs at (boot_clock.c) */
 
 		/* Enable automatic page write mode */
 		config.manual_page_write = false;
@@ -139,9 +204,11 @@ ATCA_STATUS secure_boot_init_memory(memory_parameters* memory_params)
 		memset(io_prot_key, 0xFF, sizeof(io_prot_key));
 
 	
-		/*Read memory params from the flash*/
+		/*Read memory params from the footer of the selected slot*/
+		slot_address = secure_boot_slot_start_address();
+		slot_header_address = secure_boot_slot_header_address();
 		read_data = (uint8_t*)memory_params;
-		for(header_address=USER_APPLICATION_HEADER_ADDRESS; header_address<(USER_APPLICATION_HEADER_ADDRESS+USER_APPLICATION_HEADER_SIZE);)
+		for(header_address=slot_header_address; header_address<(slot_header_address+USER_APPLICATION_HEADER_SIZE);)
 		{
 			nvm_status = nvm_read_buffer(header_address, read_data, NVMCTRL_PAGE_SIZE);
 			if(nvm_status != STATUS_OK)
@@ -152,10 +219,14 @@ ATCA_STATUS secure_boot_init_memory(memory_parameters* memory_params)
 			header_address += NVMCTRL_PAGE_SIZE;
 		}
 
+		/*memory_size is the image length plus the footer, the signed length leaves out the signature */
 		memory_params->memory_size -= sizeof(memory_params->signature);
+		partition_status = secure_boot_partition_get(memory_params, &regions, &region_count, &partition_length);
 
-		if((nvm_status != STATUS_OK) || (memory_params->start_address != USER_APPLICATION_START_ADDRESS) ||
-		(memory_params->memory_size > (USER_APPLICATION_END_ADDRESS - USER_APPLICATION_START_ADDRESS)))
+		if((nvm_status != STATUS_OK) || (partition_status != ATCA_SUCCESS) ||
+		(memory_params->start_address != slot_address) ||
+		(memory_params->memory_size < USER_APPLICATION_FOOTER_SIGNED_SIZE) ||
+		((memory_params->memory_size - USER_APPLICATION_FOOTER_SIGNED_SIZE) > (slot_header_address - slot_address)))
 		{
 			status = ATCA_GEN_FAIL;
 			flash_read_address = 0xFFFFFFFF;
@@ -163,7 +234,25 @@ ATCA_STATUS secure_boot_init_memory(memory_parameters* memory_params)
 		}
 		else
 		{
-			flash_read_address = USER_APPLICATION_START_ADDRESS;
+			flash_image_start_address = slot_address;
+			flash_image_end_address = slot_address + memory_params->memory_size - USER_APPLICATION_FOOTER_SIGNED_SIZE;
+			secure_boot_add_span(slot_address, flash_image_end_address - slot_address);
+			for(region_index = 0; region_index < region_count; region_index++)
+			{
+				secure_boot_add_span(regions[region_index].address, regions[region_index].length);
+			}
+			secure_boot_add_span(slot_header_address, USER_APPLICATION_FOOTER_SIGNED_SIZE);
+			flash_read_address = flash_spans[0].start_address;
+			flash_read_end_address = flash_spans[0].end_address;
+			flash_span_next = 1;
+
+			/*The digest covers the partitions too */
+			memory_params->memory_size += partition_length;
+
+			memcpy(footer_marker.marker, "UPDT", sizeof(footer_marker.marker));
+			footer_marker.version_info = memory_params->version_info;
+			memcpy(footer_marker.signature, memory_params->signature, sizeof(footer_marker.signature));
+			BOOT_TRACE(BOOT_TRACE_DIGEST_START, memory_params->memory_size);
 		}			
 
 	} while (0);
@@ -172,6 +261,21 @@ ATCA_STATUS secure_boot_init_memory(memory_parameters* memory_params)
 	return status;
 }
 
+/** \brief Moves on to the next span once the current one has been read
+*  \return true while there is signed data left to read
+*/
+static bool secure_boot_next_span(void)
+{
+	while((flash_read_address >= flash_read_end_address) && (flash_span_next < flash_span_count))
+	{
+		flash_read_address = flash_spans[flash_span_next].start_address;
+		flash_read_end_address = flash_spans[flash_span_next].end_address;
+		flash_span_next++;
+	}
+
+	return (flash_read_address < flash_read_end_address);
+}
+
 /** \brief This module provides interface to read data from memory
 *	\param[in, out] uint8_t* data Pointer to hold memory content
 *	\param[in] uint8_t* target_length Data bytes length to read from memory
@@ -186,6 +290,16 @@ ATCA_STATUS secure_boot_read_memory(uint8_t* data, uint32_t* target_length)
 		uint32_t read_length;
 		enum status_code nvm_status;
 
+		if(!secure_boot_next_span())
+		{
+			*target_length = 0;
+			return ATCA_GEN_FAIL;
+		}
+		if(*target_length > (flash_read_end_address - flash_read_address))
+		{
+			*target_length = flash_read_end_address - flash_read_address;
+		}
+
 		/* Set the NVM configuration */
 		nvm_status = nvm_read_buffer(flash_read_address, data, *target_length);
 
@@ -199,10 +313,66 @@ ATCA_STATUS secure_boot_read_memory(uint8_t* data, uint32_t* target_length)
 			read_length = *target_length;
 		}
 		flash_read_address += read_length;
+		if((read_length != 0) && (flash_read_address >= flash_read_end_address) && (flash_span_next >= flash_span_count))
+		{
+			BOOT_TRACE(BOOT_TRACE_DIGEST_DONE, flash_read_address);
+		}
 
 	return status;
 }
 
+/** \brief This module provides a zero-copy view of memory, flash is memory mapped
+*	\param[out] const uint8_t** data Pointer to the memory content
+*	\param[in, out] uint32_t* target_length Bytes requested, updated with bytes available
+*  \return ATCA_STATUS
+*/
+ATCA_STATUS secure_boot_map_memory(const uint8_t** data, uint32_t* target_length)
+{
+	if(!secure_boot_next_span())
+	{
+		*target_length = 0;
+		return ATCA_GEN_FAIL;
+	}
+
+	if(*target_length > (flash_read_end_address - flash_read_address))
+	{
+		*target_length = flash_read_end_address - flash_read_address;
+	}
+
+	*data = (const uint8_t*)(FLASH_ADDR + flash_read_address);
+	flash_read_address += *target_length;
+	if((flash_read_address >= flash_read_end_address) && (flash_span_next >= flash_span_count))
+	{
+		BOOT_TRACE(BOOT_TRACE_DIGEST_DONE, flash_read_address);
+	}
+
+	return ATCA_SUCCESS;
+}
+
+/** \brief Zero-copy view of the start of the application, independent of the
+ *         read position. Used to time the digest engines on a sample.
+*	\param[out] const uint8_t** data Pointer to the memory content
+*	\param[in, out] uint32_t* target_length Bytes requested, updated with bytes available
+*  \return ATCA_STATUS
+*/
+ATCA_STATUS secure_boot_sample_memory(const uint8_t** data, uint32_t* target_length)
+{
+	if(flash_image_end_address <= flash_image_start_address)
+	{
+		*target_length = 0;
+		return ATCA_GEN_FAIL;
+	}
+
+	if(*target_length > (flash_image_end_address - flash_image_start_address))
+	{
+		*target_length = flash_image_end_address - flash_image_start_address;
+	}
+
+	*data = (const uint8_t*)(FLASH_ADDR + flash_image_start_address);
+
+	return ATCA_SUCCESS;
+}
+
 /** \brief This module provides interface to write data to memory
 *	\param[in, out] uint8_t* data Pointer to hold memory content
 *	\param[in] uint8_t* target_length Data bytes length to write to memory
@@ -214,38 +384,34 @@ ATCA_STATUS secure_boot_write_memory(uint8_t* data, uint32_t* target_length)
 	return ATCA_UNIMPLEMENTED;
 }
 
-/** \brief This module marks flash to indicate Secure Boot verification is completed on Upgrade
+/** \brief This module marks flash to indicate Secure Boot verification is completed on Upgrade.
+ *         The marker records the footer version and signature of the verified image.
 *  \return ATCA_STATUS
 */
 ATCA_STATUS secure_boot_mark_full_copy_completion(void)
 {
-	ATCA_STATUS status = ATCA_SUCCESS;
-	enum status_code nvm_status;
-	uint8_t* const update_notify = "UPDT";
+	ATCA_STATUS status;
 
-	/*First ATCA_KEY_SIZE bytes contains Key and rest is loaded from ram/stack */
-	nvm_status = nvm_update_buffer(USER_APPLICATION_END_ADDRESS, update_notify, 0, sizeof(uint32_t));
-	if(nvm_status != STATUS_OK)
-	{
-		status = ATCA_GEN_FAIL;
-	}
+	/*One journal record, no row erase */
+	status = boot_journal_write(BOOT_JOURNAL_UPDATE_MARKER, &footer_marker, sizeof(footer_marker));
+	BOOT_TRACE(BOOT_TRACE_FULL_COPY_MARKED, status);
 
 	return status;
 }
 
-/** \brief This module marks flash to indicate Secure Boot verification is completed on Upgrade
-*  \return ATCA_STATUS
+/** \brief This module checks whether Secure Boot verification is completed on Upgrade.
+ *         A marker left by a previous image (different footer version or signature)
+ *         does not count, so a changed image is signature verified again.
+*  \return true if the device holds the digest of the current image
 */
 bool secure_boot_check_full_copy_completion(void)
 {
 	bool is_completed;
-	uint8_t* const update_notify = "UPDT";
-	uint32_t flash_mark;
-	enum status_code nvm_status;
+	update_marker flash_marker;
 
 	is_completed = false;
-	nvm_status = nvm_read_buffer(USER_APPLICATION_END_ADDRESS, (uint8_t* const)&flash_mark, sizeof(flash_mark));
-	if((nvm_status == STATUS_OK) && (0 == memcmp(&flash_mark, update_notify, sizeof(flash_mark))))
+	if(boot_journal_read(BOOT_JOURNAL_UPDATE_MARKER, &flash_marker, sizeof(flash_marker)) &&
+	(0 == memcmp(&flash_marker, &footer_marker, sizeof(flash_marker))))
 	{
 		is_completed = true;
 	}
@@ -260,36 +426,19 @@ bool secure_boot_check_full_copy_completion(void)
 */
 void secure_boot_deinit_memory(memory_parameters* memory_params)
 {
-
+	BOOT_TRACE(BOOT_TRACE_MEMORY_DEINIT, 0);
 }
 
 
 
+/** \brief Host nonce for the SecureBoot MAC exchange, NONCE_NUMIN_SIZE bytes
+*	\param[out] rand_num random number
+*  \return ATCA_STATUS
+*/
 ATCA_STATUS host_generate_random_number(uint8_t *rand_num)
 {
-	uint32_t random_num=0;
-	
-	random_num=rand();
-	memcpy(rand_num,&random_num,4);
-	
-	rand_num+=4;
-	random_num=rand();
-	memcpy(rand_num,&random_num,4);
-	
-	rand_num+=4;
-	random_num=rand();
-	memcpy(rand_num,&random_num,4);
-	
-	rand_num+=4;
-	random_num=rand();
-	memcpy(rand_num,&random_num,4);
-	
-	rand_num+=4;
-	random_num=rand();
-	memcpy(rand_num,&random_num,4);
-	
-	return ATCA_SUCCESS;
-	
+	BOOT_TRACE(BOOT_TRACE_HOST_RANDOM, 0);
+	return secure_boot_drbg_generate(rand_num, NONCE_NUMIN_SIZE);
 }
 
 
@@ -0,0 +1,98 @@
+/**
+ * \file
+ *
+ * \brief Flash partitions signed together with the application image.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <string.h>
+#include <asf.h>
+#include "cryptoauthlib.h"
+#include "memory_conf.h"
+#include "secure_boot_partition.h"
+
+/*
+ * Data and asset regions outside the application are listed in the footer
+ * and hashed into the same digest as the image, between the image and the
+ * footer. The device verifies one signature for all of them, instead of one
+ * per region. Regions must be in flash above the rows the bootloader keeps
+ * after the application, row aligned, in ascending order and must not
+ * overlap.
+ */
+
+/** \brief Checks whether the footer lists partitions
+ *  \param[in] const memory_parameters* memory_params Footer of the image
+ *  \return true if the footer holds a partition descriptor
+ */
+bool secure_boot_partition_is_manifest(const memory_parameters* memory_params)
+{
+    return (memcmp(memory_params->reserved, "PART", 4) == 0);
+}
+
+/** \brief Returns the partitions the footer lists
+ *  \param[in] const memory_parameters* memory_params Footer of the image
+ *  \param[out] const secure_boot_partition_region** regions Regions, in the footer
+ *  \param[out] uint8_t* count Regions, 0 if the footer lists none
+ *  \param[out] uint32_t* length Bytes of all regions
+ *  \return ATCA_SUCCESS if there are no partitions or all are valid, otherwise ATCA_BAD_PARAM
+ */
+ATCA_STATUS secure_boot_partition_get(const memory_parameters* memory_params, const secure_boot_partition_region** regions,
+                                      uint8_t* count, uint32_t* length)
+{
+    const secure_boot_partition_manifest* manifest = (const secure_boot_partition_manifest*)memory_params->reserved;
+    uint32_t next_address = SECURE_BOOT_PARTITION_START_ADDRESS;
+    uint8_t index;
+
+    *regions = manifest->regions;
+    *count = 0;
+    *length = 0;
+    if (!secure_boot_partition_is_manifest(memory_params))
+    {
+        return ATCA_SUCCESS;
+    }
+
+    if ((manifest->count == 0) || (manifest->count > SECURE_BOOT_PARTITION_MAX))
+    {
+        return ATCA_BAD_PARAM;
+    }
+
+    for (index = 0; index < manifest->count; index++)
+    {
+        const secure_boot_partition_region* region = &manifest->regions[index];
+
+        if ((region->address < next_address) || (region->address & (NVMCTRL_ROW_SIZE - 1)) ||
+            (region->length == 0) || (region->address > SECURE_BOOT_PARTITION_END_ADDRESS) ||
+            (region->length > (SECURE_BOOT_PARTITION_END_ADDRESS - region->address)))
+        {
+            *length = 0;
+            return ATCA_BAD_PARAM;
+        }
+        next_address = region->address + region->length;
+        *length += region->length;
+    }
+    *count = manifest->count;
+
+    return ATCA_SUCCESS;
+}
@@ -0,0 +1,71 @@
+/**
+ * \file
+ *
+ * \brief Flash partitions signed together with the application image.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef SECURE_BOOT_PARTITION_H
+#define SECURE_BOOT_PARTITION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "secure_boot.h"
+
+/** Regions the descriptor has room for in the footer's reserved field */
+#define SECURE_BOOT_PARTITION_MAX           5
+
+/** \brief Flash region signed with the application */
+typedef struct
+{
+    uint32_t address;                   /**< Row aligned, at or above SECURE_BOOT_PARTITION_START_ADDRESS */
+    uint32_t length;
+} secure_boot_partition_region;
+
+/** \brief Partition descriptor at the start of memory_parameters.reserved.
+ *         The signed data is then the image, each region in the order listed
+ *         and the footer, so one signature and one verification cover all of
+ *         them. The descriptor is part of the signed footer. */
+typedef struct
+{
+    uint8_t magic[4];                   /**< "PART" */
+    uint8_t count;                      /**< Regions used, 1 to SECURE_BOOT_PARTITION_MAX */
+    uint8_t reserved[3];
+    secure_boot_partition_region regions[SECURE_BOOT_PARTITION_MAX];
+} secure_boot_partition_manifest;
+
+bool secure_boot_partition_is_manifest(const memory_parameters* memory_params);
+ATCA_STATUS secure_boot_partition_get(const memory_parameters* memory_params, const secure_boot_partition_region** regions,
+                                      uint8_t* count, uint32_t* length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,163 @@
+/**
+ * \file
+ *
+ * \brief Application slots: selection of the slot to verify and execute.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <asf.h>
+#include "cryptoauthlib.h"
+#include "secure_boot.h"
+#include "memory_conf.h"
+#include "secure_boot_slot.h"
+
+/*
+ * The application region is split in two slots of the same size, each with
+ * its footer in its last two pages. An image is linked for the slot it is
+ * written to and executes in place from there, nothing is copied or swapped.
+ * An update goes to the slot that is not running, and the bootloader
+ * verifies the slot holding the higher footer version first, slot A on a
+ * tie. If that image fails, the other slot is verified instead, so a bad or
+ * interrupted update falls back to the previous image.
+ *
+ * A slot holds an image when its reset vector is programmed and its footer
+ * gives the slot as start address, an image linked for the other slot is
+ * never executed from it.
+ */
+
+static const uint32_t secure_boot_slot_addresses[USER_APPLICATION_SLOT_COUNT] =
+{
+    USER_APPLICATION_START_ADDRESS,
+    USER_APPLICATION_SLOT_B_ADDRESS
+};
+
+static uint8_t secure_boot_slot_current = SECURE_BOOT_SLOT_A;
+/** Slots selected since secure_boot_slot_select_first(), one bit per slot */
+static uint8_t secure_boot_slot_tried;
+
+/** \brief Returns the footer of a slot, in memory mapped flash */
+static const memory_parameters* secure_boot_slot_footer(uint8_t slot)
+{
+    return (const memory_parameters*)(FLASH_ADDR + secure_boot_slot_addresses[slot] + USER_APPLICATION_SLOT_SIZE -
+                                      USER_APPLICATION_HEADER_SIZE);
+}
+
+/** \brief Checks whether a slot holds an image linked for it */
+static bool secure_boot_slot_has_image(uint8_t slot)
+{
+    const uint32_t* vectors = (const uint32_t*)(FLASH_ADDR + secure_boot_slot_addresses[slot]);
+
+    return (vectors[1] != 0xFFFFFFFFUL) && (secure_boot_slot_footer(slot)->start_address == secure_boot_slot_addresses[slot]);
+}
+
+/** \brief Selects the slot with the newest image that has not been tried
+ *  \return true if a slot was selected
+ */
+static bool secure_boot_slot_select_newest(void)
+{
+    bool found = false;
+    uint8_t slot;
+
+    for (slot = 0; slot < USER_APPLICATION_SLOT_COUNT; slot++)
+    {
+        if ((secure_boot_slot_tried & (1U << slot)) || !secure_boot_slot_has_image(slot))
+        {
+            continue;
+        }
+        if (!found || (secure_boot_slot_footer(slot)->version_info > secure_boot_slot_footer(secure_boot_slot_current)->version_info))
+        {
+            secure_boot_slot_current = slot;
+            found = true;
+        }
+    }
+    if (found)
+    {
+        secure_boot_slot_tried |= 1U << secure_boot_slot_current;
+    }
+
+    return found;
+}
+
+/** \brief Selects the slot to verify first on this boot
+ *  \return true if a slot holds an image, false if both are erased
+ */
+bool secure_boot_slot_select_first(void)
+{
+    secure_boot_slot_tried = 0;
+
+    return secure_boot_slot_select_newest();
+}
+
+/** \brief Selects the slot to fall back to once the selected one failed
+ *  \return true if a slot that has not been tried holds an image
+ */
+bool secure_boot_slot_select_next(void)
+{
+    return secure_boot_slot_select_newest();
+}
+
+/** \brief Selects the slot an image starts at
+ *  \param[in] uint32_t start_address Start address of the image
+ *  \return true if the address is the start of a slot
+ */
+bool secure_boot_slot_select_address(uint32_t start_address)
+{
+    uint8_t slot;
+
+    for (slot = 0; slot < USER_APPLICATION_SLOT_COUNT; slot++)
+    {
+        if (secure_boot_slot_addresses[slot] == start_address)
+        {
+            secure_boot_slot_current = slot;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/** \brief Returns the index of the selected slot */
+uint8_t secure_boot_slot_selected(void)
+{
+    return secure_boot_slot_current;
+}
+
+/** \brief Returns the start address of a slot */
+uint32_t secure_boot_slot_address(uint8_t slot)
+{
+    return secure_boot_slot_addresses[slot];
+}
+
+/** \brief Returns the start address of the selected slot, its vector table */
+uint32_t secure_boot_slot_start_address(void)
+{
+    return secure_boot_slot_addresses[secure_boot_slot_current];
+}
+
+/** \brief Returns the footer address of the selected slot */
+uint32_t secure_boot_slot_header_address(void)
+{
+    return secure_boot_slot_addresses[secure_boot_slot_current] + USER_APPLICATION_SLOT_SIZE - USER_APPLICATION_HEADER_SIZE;
+}
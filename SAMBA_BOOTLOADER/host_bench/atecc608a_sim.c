@@ -0,0 +1,866 @@
+/**
+ * \file
+ *
+ * \brief Transaction level ATECC608A model for the secure boot bench.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <string.h>
+#include <openssl/evp.h>
+#include <openssl/ecdsa.h>
+#include <openssl/bn.h>
+#include <openssl/x509.h>
+#include "cryptoauthlib.h"
+#include "host/atca_host.h"
+#include "atecc608a_sim.h"
+#include "bench_clock.h"
+
+/* Device status codes returned in a 4 byte response */
+#define SIM_STATUS_SUCCESS          0x00
+#define SIM_STATUS_MISCOMPARE       0x01
+#define SIM_STATUS_PARSE_ERROR      0x03
+#define SIM_STATUS_EXECUTION_ERROR  0x0F
+#define SIM_STATUS_AFTER_WAKE       0x11
+#define SIM_STATUS_CRC_ERROR        0xFF
+
+/* I2C word address values */
+#define SIM_WORD_ADDRESS_RESET      0x00
+#define SIM_WORD_ADDRESS_SLEEP      0x01
+#define SIM_WORD_ADDRESS_IDLE       0x02
+#define SIM_WORD_ADDRESS_COMMAND    0x03
+
+/* Configuration zone fields */
+#define SIM_CFG_I2C_ADDRESS         16
+#define SIM_CFG_SLOT_CONFIG         20
+#define SIM_CFG_SECURE_BOOT         70
+#define SIM_CFG_LOCK_VALUE          86
+#define SIM_CFG_LOCK_CONFIG         87
+#define SIM_CFG_SLOT_LOCKED         88
+#define SIM_CFG_CHIP_OPTIONS        90
+
+#define SIM_SLOT_MAX_SIZE           416
+#define SIM_RESPONSE_MAX            (SECUREBOOT_MAC_SIZE + 3)
+
+typedef enum
+{
+    SIM_STATE_SLEEP,
+    SIM_STATE_IDLE,
+    SIM_STATE_AWAKE
+} sim_state;
+
+/** \brief Execution time of one opcode, in microseconds */
+typedef struct
+{
+    uint8_t  opcode;
+    uint32_t typical_us;
+    uint32_t max_us;
+} sim_exec_time;
+
+/*
+ * Maximum times follow the cryptoauthlib ATECC608A execution table (clock
+ * divider 0). Typical times are what the model charges by default; they are
+ * estimates to be refined against bus captures from real parts.
+ */
+static const sim_exec_time exec_times[] = {
+    { ATCA_READ,        800,    5000 },
+    { ATCA_WRITE,       7000,   45000 },
+    { ATCA_LOCK,        8000,   35000 },
+    { ATCA_RANDOM,      1500,   23000 },
+    { ATCA_NONCE,       1500,   20000 },
+    { ATCA_INFO,        500,    5000 },
+    { ATCA_SHA,         1200,   36000 },
+    { ATCA_GENDIG,      5000,   25000 },
+    { ATCA_VERIFY,      40000,  105000 },
+    { ATCA_SECUREBOOT,  40000,  80000 },
+};
+
+/* SecureBoot that only compares a stored digest skips the ECDSA engine */
+#define SIM_SECUREBOOT_DIGEST_ONLY_US   2000
+
+static struct
+{
+    uint8_t         config[ATECC608A_SIM_CONFIG_SIZE];
+    uint8_t         otp[64];
+    uint8_t         slots[ATECC608A_SIM_SLOT_COUNT][SIM_SLOT_MAX_SIZE];
+    sim_state       state;
+    uint64_t        wake_ns;
+    uint64_t        busy_until_ns;
+    uint8_t         response[SIM_RESPONSE_MAX];
+    size_t          response_length;
+    size_t          response_offset;
+    atca_temp_key_t temp_key;
+    EVP_MD_CTX*     sha_ctx;
+    uint64_t        rng_state;
+    atecc608a_sim_timing timing;
+    atecc608a_sim_stats  stats;
+} sim;
+
+static size_t slot_size(uint8_t slot)
+{
+    if (slot < 8)
+    {
+        return 36;
+    }
+    return (slot == 8) ? 416 : 72;
+}
+
+static bool config_locked(void)
+{
+    return sim.config[SIM_CFG_LOCK_CONFIG] != 0x55;
+}
+
+static bool data_locked(void)
+{
+    return sim.config[SIM_CFG_LOCK_VALUE] != 0x55;
+}
+
+static bool slot_locked(uint8_t slot)
+{
+    uint16_t slot_locked_bits = sim.config[SIM_CFG_SLOT_LOCKED] | (sim.config[SIM_CFG_SLOT_LOCKED + 1] << 8);
+
+    return (slot_locked_bits & (1u << slot)) == 0;
+}
+
+static uint16_t slot_config(uint8_t slot)
+{
+    return sim.config[SIM_CFG_SLOT_CONFIG + slot * 2] | (sim.config[SIM_CFG_SLOT_CONFIG + slot * 2 + 1] << 8);
+}
+
+static uint8_t device_address(void)
+{
+    /* A new I2C address only takes effect once the configuration is locked */
+    return config_locked() ? sim.config[SIM_CFG_I2C_ADDRESS] : ATECC608A_SIM_DEFAULT_ADDRESS;
+}
+
+static void crc16(size_t length, const uint8_t* data, uint8_t* crc_le)
+{
+    uint16_t crc_register = 0;
+
+    for (size_t counter = 0; counter < length; counter++)
+    {
+        for (uint8_t shift_register = 0x01; shift_register > 0x00; shift_register <<= 1)
+        {
+            uint8_t data_bit = (data[counter] & shift_register) ? 1 : 0;
+            uint8_t crc_bit = crc_register >> 15;
+
+            crc_register <<= 1;
+            if (data_bit != crc_bit)
+            {
+                crc_register ^= 0x8005;
+            }
+        }
+    }
+    crc_le[0] = (uint8_t)(crc_register & 0x00FF);
+    crc_le[1] = (uint8_t)(crc_register >> 8);
+}
+
+static void set_response(const uint8_t* data, size_t length)
+{
+    sim.response[0] = (uint8_t)(length + 3);
+    memcpy(&sim.response[1], data, length);
+    crc16(length + 1, sim.response, &sim.response[length + 1]);
+    sim.response_length = length + 3;
+    sim.response_offset = 0;
+}
+
+static void set_status(uint8_t status)
+{
+    set_response(&status, 1);
+}
+
+static void fill_random(uint8_t* data, size_t length)
+{
+    if (!config_locked())
+    {
+        /* Unlocked parts return a fixed test pattern */
+        for (size_t i = 0; i < length; i++)
+        {
+            data[i] = (i & 2) ? 0x00 : 0xFF;
+        }
+        return;
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        sim.rng_state ^= sim.rng_state << 13;
+        sim.rng_state ^= sim.rng_state >> 7;
+        sim.rng_state ^= sim.rng_state << 17;
+        data[i] = (uint8_t)(sim.rng_state >> 24);
+    }
+}
+
+static uint32_t exec_time_us(uint8_t opcode)
+{
+    for (size_t i = 0; i < sizeof(exec_times) / sizeof(exec_times[0]); i++)
+    {
+        if (exec_times[i].opcode == opcode)
+        {
+            return (sim.timing == ATECC608A_SIM_TIMING_MAX) ? exec_times[i].max_us : exec_times[i].typical_us;
+        }
+    }
+    return 1000;
+}
+
+static bool ecdsa_verify(const uint8_t* public_key_slot, const uint8_t* digest, const uint8_t* signature)
+{
+    static const uint8_t p256_spki_prefix[] = {
+        0x30, 0x59, 0x30, 0x13, 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01,
+        0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x07, 0x03, 0x42, 0x00, 0x04
+    };
+    uint8_t spki[sizeof(p256_spki_prefix) + ATCA_PUB_KEY_SIZE];
+    const uint8_t* spki_ptr = spki;
+    uint8_t* der_sig = NULL;
+    int der_sig_length;
+    EVP_PKEY* pkey = NULL;
+    EVP_PKEY_CTX* ctx = NULL;
+    ECDSA_SIG* sig = NULL;
+    bool verified = false;
+
+    /* Slot format: 4 pad bytes, X, 4 pad bytes, Y */
+    memcpy(spki, p256_spki_prefix, sizeof(p256_spki_prefix));
+    memcpy(&spki[sizeof(p256_spki_prefix)], &public_key_slot[4], 32);
+    memcpy(&spki[sizeof(p256_spki_prefix) + 32], &public_key_slot[40], 32);
+
+    do
+    {
+        if ((pkey = d2i_PUBKEY(NULL, &spki_ptr, sizeof(spki))) == NULL)
+        {
+            break;
+        }
+        if ((sig = ECDSA_SIG_new()) == NULL)
+        {
+            break;
+        }
+        if (!ECDSA_SIG_set0(sig, BN_bin2bn(&signature[0], 32, NULL), BN_bin2bn(&signature[32], 32, NULL)))
+        {
+            break;
+        }
+        if ((der_sig_length = i2d_ECDSA_SIG(sig, &der_sig)) <= 0)
+        {
+            break;
+        }
+        if ((ctx = EVP_PKEY_CTX_new(pkey, NULL)) == NULL || EVP_PKEY_verify_init(ctx) <= 0)
+        {
+            break;
+        }
+        verified = (EVP_PKEY_verify(ctx, der_sig, der_sig_length, digest, ATCA_SHA_DIGEST_SIZE) == 1);
+    }
+    while (0);
+
+    OPENSSL_free(der_sig);
+    ECDSA_SIG_free(sig);
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(pkey);
+
+    return verified;
+}
+
+static uint32_t cmd_read(uint8_t param1, uint16_t param2)
+{
+    uint8_t zone = param1 & 0x03;
+    size_t length = (param1 & 0x80) ? ATCA_BLOCK_SIZE : ATCA_WORD_SIZE;
+    size_t offset = ((param2 >> 3) & 0x1F) * ATCA_BLOCK_SIZE + (param2 & 0x07) * ATCA_WORD_SIZE;
+
+    if (zone == ATCA_ZONE_CONFIG)
+    {
+        if (offset + length > sizeof(sim.config))
+        {
+            set_status(SIM_STATUS_PARSE_ERROR);
+        }
+        else
+        {
+            set_response(&sim.config[offset], length);
+        }
+    }
+    else if (zone == ATCA_ZONE_DATA)
+    {
+        uint8_t slot = (param2 >> 3) & 0x0F;
+
+        offset = ((param2 >> 8) & 0xFF) * ATCA_BLOCK_SIZE + (param2 & 0x07) * ATCA_WORD_SIZE;
+        if (offset + length > slot_size(slot))
+        {
+            set_status(SIM_STATUS_PARSE_ERROR);
+        }
+        else if (!data_locked() || (slot_config(slot) & 0x0080))
+        {
+            /* Data zone is unreadable until locked; IsSecret slots never are */
+            set_status(SIM_STATUS_EXECUTION_ERROR);
+        }
+        else
+        {
+            set_response(&sim.slots[slot][offset], length);
+        }
+    }
+    else
+    {
+        if (offset + length > sizeof(sim.otp))
+        {
+            set_status(SIM_STATUS_PARSE_ERROR);
+        }
+        else
+        {
+            set_response(&sim.otp[offset], length);
+        }
+    }
+
+    return exec_time_us(ATCA_READ);
+}
+
+static uint32_t cmd_write(uint8_t param1, uint16_t param2, const uint8_t* data, size_t data_length)
+{
+    uint8_t zone = param1 & 0x03;
+    size_t length = (param1 & 0x80) ? ATCA_BLOCK_SIZE : ATCA_WORD_SIZE;
+    size_t offset = ((param2 >> 3) & 0x1F) * ATCA_BLOCK_SIZE + (param2 & 0x07) * ATCA_WORD_SIZE;
+
+    if ((data_length != length) || (param1 & 0x40))
+    {
+        /* Encrypted writes are not modelled */
+        set_status(SIM_STATUS_PARSE_ERROR);
+    }
+    else if (zone == ATCA_ZONE_CONFIG)
+    {
+        if (config_locked() || (offset < 16) || (offset + length > sizeof(sim.config)))
+        {
+            set_status(SIM_STATUS_EXECUTION_ERROR);
+        }
+        else
+        {
+            for (size_t i = 0; i < length; i++)
+            {
+                /* UserExtra, Selector and the lock bytes are not writable */
+                if ((offset + i) < 84 || (offset + i) > SIM_CFG_LOCK_CONFIG)
+                {
+                    sim.config[offset + i] = data[i];
+                }
+            }
+            set_status(SIM_STATUS_SUCCESS);
+        }
+    }
+    else if (zone == ATCA_ZONE_DATA)
+    {
+        uint8_t slot = (param2 >> 3) & 0x0F;
+
+        offset = ((param2 >> 8) & 0xFF) * ATCA_BLOCK_SIZE + (param2 & 0x07) * ATCA_WORD_SIZE;
+        if (!config_locked() || (offset + length > slot_size(slot)) || (data_locked() && slot_locked(slot)))
+        {
+            set_status(SIM_STATUS_EXECUTION_ERROR);
+        }
+        else
+        {
+            memcpy(&sim.slots[slot][offset], data, length);
+            set_status(SIM_STATUS_SUCCESS);
+        }
+    }
+    else
+    {
+        if (data_locked() || (offset + length > sizeof(sim.otp)))
+        {
+            set_status(SIM_STATUS_EXECUTION_ERROR);
+        }
+        else
+        {
+            memcpy(&sim.otp[offset], data, length);
+            set_status(SIM_STATUS_SUCCESS);
+        }
+    }
+
+    return exec_time_us(ATCA_WRITE);
+}
+
+static uint32_t cmd_lock(uint8_t param1)
+{
+    uint8_t status = SIM_STATUS_SUCCESS;
+
+    switch (param1 & 0x03)
+    {
+    case LOCK_ZONE_CONFIG:
+        if (config_locked())
+        {
+            status = SIM_STATUS_EXECUTION_ERROR;
+        }
+        else
+        {
+            atecc608a_sim_lock_config();
+        }
+        break;
+
+    case LOCK_ZONE_DATA:
+        if (!config_locked() || data_locked())
+        {
+            status = SIM_STATUS_EXECUTION_ERROR;
+        }
+        else
+        {
+            atecc608a_sim_lock_data();
+        }
+        break;
+
+    case 2:
+        if (!data_locked() || slot_locked((param1 >> 2) & 0x0F))
+        {
+            status = SIM_STATUS_EXECUTION_ERROR;
+        }
+        else
+        {
+            atecc608a_sim_lock_slot((param1 >> 2) & 0x0F);
+        }
+        break;
+
+    default:
+        status = SIM_STATUS_PARSE_ERROR;
+        break;
+    }
+    set_status(status);
+
+    return exec_time_us(ATCA_LOCK);
+}
+
+static uint32_t cmd_random(void)
+{
+    uint8_t random[RANDOM_NUM_SIZE];
+
+    fill_random(random, sizeof(random));
+    set_response(random, sizeof(random));
+
+    return exec_time_us(ATCA_RANDOM);
+}
+
+static uint32_t cmd_nonce(uint8_t param1, const uint8_t* data, size_t data_length)
+{
+    uint8_t rand_out[RANDOM_NUM_SIZE];
+    atca_nonce_in_out_t nonce_params;
+
+    memset(&nonce_params, 0, sizeof(nonce_params));
+    nonce_params.mode = param1;
+    nonce_params.num_in = data;
+    nonce_params.rand_out = rand_out;
+    nonce_params.temp_key = &sim.temp_key;
+
+    if ((param1 & 0x03) == 0x03)
+    {
+        if ((data_length != 32) || (atcah_nonce(&nonce_params) != ATCA_SUCCESS))
+        {
+            set_status(SIM_STATUS_PARSE_ERROR);
+        }
+        else
+        {
+            set_status(SIM_STATUS_SUCCESS);
+        }
+    }
+    else if ((param1 & 0x03) <= 0x01 && data_length == NONCE_NUMIN_SIZE)
+    {
+        fill_random(rand_out, sizeof(rand_out));
+        if (atcah_nonce(&nonce_params) != ATCA_SUCCESS)
+        {
+            set_status(SIM_STATUS_EXECUTION_ERROR);
+        }
+        else
+        {
+            set_response(rand_out, sizeof(rand_out));
+        }
+    }
+    else
+    {
+        set_status(SIM_STATUS_PARSE_ERROR);
+    }
+
+    return exec_time_us(ATCA_NONCE);
+}
+
+static uint32_t cmd_info(uint8_t param1)
+{
+    static const uint8_t revision[INFO_SIZE] = { 0x00, 0x00, 0x60, 0x02 };
+    static const uint8_t zero[INFO_SIZE] = { 0x00, 0x00, 0x00, 0x00 };
+
+    set_response((param1 == 0x00) ? revision : zero, INFO_SIZE);
+
+    return exec_time_us(ATCA_INFO);
+}
+
+static uint32_t cmd_sha(uint8_t param1, const uint8_t* data, size_t data_length)
+{
+    uint8_t digest[ATCA_SHA_DIGEST_SIZE];
+    unsigned int digest_length = sizeof(digest);
+
+    switch (param1 & 0x07)
+    {
+    case SHA_MODE_SHA256_START:
+        EVP_DigestInit_ex(sim.sha_ctx, EVP_sha256(), NULL);
+        set_status(SIM_STATUS_SUCCESS);
+        break;
+
+    case 0x01:  /* Update, exactly one block */
+        if (data_length != ATCA_SHA256_BLOCK_SIZE)
+        {
+            set_status(SIM_STATUS_PARSE_ERROR);
+            break;
+        }
+        EVP_DigestUpdate(sim.sha_ctx, data, data_length);
+        set_status(SIM_STATUS_SUCCESS);
+        break;
+
+    case 0x02:  /* End, up to 63 trailing bytes */
+        if (data_length >= ATCA_SHA256_BLOCK_SIZE)
+        {
+            set_status(SIM_STATUS_PARSE_ERROR);
+            break;
+        }
+        EVP_DigestUpdate(sim.sha_ctx, data, data_length);
+        EVP_DigestFinal_ex(sim.sha_ctx, digest, &digest_length);
+        memcpy(sim.temp_key.value, digest, sizeof(digest));
+        sim.temp_key.valid = 1;
+        set_response(digest, sizeof(digest));
+        break;
+
+    default:
+        set_status(SIM_STATUS_PARSE_ERROR);
+        break;
+    }
+
+    return exec_time_us(ATCA_SHA);
+}
+
+static uint32_t cmd_secureboot(uint8_t param1, uint16_t param2, const uint8_t* data, size_t data_length)
+{
+    uint8_t sboot_mode = sim.config[SIM_CFG_SECURE_BOOT] & SECUREBOOTCONFIG_MODE_MASK;
+    uint8_t sigdig_slot = sim.config[SIM_CFG_SECURE_BOOT + 1] & 0x0F;
+    uint8_t pubkey_slot = sim.config[SIM_CFG_SECURE_BOOT + 1] >> 4;
+    uint8_t io_key_slot = sim.config[SIM_CFG_CHIP_OPTIONS + 1] >> 4;
+    uint8_t command_mode = param1 & 0x07;
+    bool enc_mac = (param1 & SECUREBOOT_MODE_ENC_MAC_FLAG) != 0;
+    const uint8_t* signature = (data_length >= SECUREBOOT_DIGEST_SIZE + SECUREBOOT_SIGNATURE_SIZE) ? &data[SECUREBOOT_DIGEST_SIZE] : NULL;
+    uint8_t digest[SECUREBOOT_DIGEST_SIZE];
+    uint8_t hashed_key[ATCA_KEY_SIZE];
+    uint8_t mac[SECUREBOOT_MAC_SIZE];
+    bool run_ecdsa = true;
+    bool valid = false;
+
+    if ((data_length < SECUREBOOT_DIGEST_SIZE) || (sboot_mode == SECUREBOOTCONFIG_MODE_DISABLED) ||
+        (command_mode < SECUREBOOT_MODE_FULL) || (command_mode > SECUREBOOT_MODE_FULL_COPY))
+    {
+        set_status(SIM_STATUS_PARSE_ERROR);
+        return exec_time_us(ATCA_SECUREBOOT);
+    }
+
+    memcpy(digest, data, sizeof(digest));
+    if (enc_mac)
+    {
+        atca_secureboot_enc_in_out_t enc_params;
+        uint8_t digest_enc[SECUREBOOT_DIGEST_SIZE];
+
+        if (!sim.temp_key.valid)
+        {
+            set_status(SIM_STATUS_EXECUTION_ERROR);
+            return exec_time_us(ATCA_SECUREBOOT);
+        }
+
+        /* The encryption is an XOR with the hashed key, so it also decrypts */
+        memset(&enc_params, 0, sizeof(enc_params));
+        enc_params.io_key = sim.slots[io_key_slot];
+        enc_params.temp_key = &sim.temp_key;
+        enc_params.digest = data;
+        enc_params.hashed_key = hashed_key;
+        enc_params.digest_enc = digest_enc;
+        atcah_secureboot_enc(&enc_params);
+        memcpy(digest, digest_enc, sizeof(digest));
+    }
+
+    if (command_mode == SECUREBOOT_MODE_FULL && sboot_mode == SECUREBOOTCONFIG_MODE_FULL_DIG)
+    {
+        valid = (memcmp(digest, sim.slots[sigdig_slot], sizeof(digest)) == 0);
+        run_ecdsa = false;
+    }
+    else if (command_mode == SECUREBOOT_MODE_FULL && sboot_mode == SECUREBOOTCONFIG_MODE_FULL_SIG)
+    {
+        valid = ecdsa_verify(sim.slots[pubkey_slot], digest, sim.slots[sigdig_slot]);
+    }
+    else if (signature != NULL)
+    {
+        valid = ecdsa_verify(sim.slots[pubkey_slot], digest, signature);
+        if (valid && command_mode != SECUREBOOT_MODE_FULL)
+        {
+            /* FullStore/FullCopy keep the digest or signature for later boots */
+            if (sboot_mode == SECUREBOOTCONFIG_MODE_FULL_DIG)
+            {
+                memcpy(sim.slots[sigdig_slot], digest, sizeof(digest));
+            }
+            else if (sboot_mode == SECUREBOOTCONFIG_MODE_FULL_SIG)
+            {
+                memcpy(sim.slots[sigdig_slot], signature, SECUREBOOT_SIGNATURE_SIZE);
+            }
+        }
+    }
+    else
+    {
+        set_status(SIM_STATUS_PARSE_ERROR);
+        return exec_time_us(ATCA_SECUREBOOT);
+    }
+
+    if (!valid)
+    {
+        set_status(SIM_STATUS_MISCOMPARE);
+    }
+    else if (enc_mac)
+    {
+        atca_secureboot_mac_in_out_t mac_params;
+
+        memset(&mac_params, 0, sizeof(mac_params));
+        mac_params.mode = param1;
+        mac_params.param2 = param2;
+        mac_params.secure_boot_config = sim.config[SIM_CFG_SECURE_BOOT] | (sim.config[SIM_CFG_SECURE_BOOT + 1] << 8);
+        mac_params.hashed_key = hashed_key;
+        mac_params.digest = digest;
+        mac_params.signature = signature;
+        mac_params.mac = mac;
+        atcah_secureboot_mac(&mac_params);
+        set_response(mac, sizeof(mac));
+    }
+    else
+    {
+        set_status(SIM_STATUS_SUCCESS);
+    }
+
+    /* TempKey is consumed by the command */
+    sim.temp_key.valid = 0;
+
+    if (!run_ecdsa && sim.timing == ATECC608A_SIM_TIMING_TYPICAL)
+    {
+        return SIM_SECUREBOOT_DIGEST_ONLY_US;
+    }
+    return exec_time_us(ATCA_SECUREBOOT);
+}
+
+static void execute_command(const uint8_t* packet, size_t length)
+{
+    uint8_t crc[2];
+    uint8_t opcode;
+    uint8_t param1;
+    uint16_t param2;
+    const uint8_t* data;
+    size_t data_length;
+    uint32_t exec_us;
+
+    if ((length < 7) || (packet[0] != length))
+    {
+        set_status(SIM_STATUS_PARSE_ERROR);
+        return;
+    }
+    crc16(length - 2, packet, crc);
+    if (memcmp(crc, &packet[length - 2], sizeof(crc)) != 0)
+    {
+        set_status(SIM_STATUS_CRC_ERROR);
+        return;
+    }
+
+    opcode = packet[1];
+    param1 = packet[2];
+    param2 = packet[3] | (packet[4] << 8);
+    data = &packet[5];
+    data_length = length - 7;
+
+    switch (opcode)
+    {
+    case ATCA_READ:         exec_us = cmd_read(param1, param2); break;
+    case ATCA_WRITE:        exec_us = cmd_write(param1, param2, data, data_length); break;
+    case ATCA_LOCK:         exec_us = cmd_lock(param1); break;
+    case ATCA_RANDOM:       exec_us = cmd_random(); break;
+    case ATCA_NONCE:        exec_us = cmd_nonce(param1, data, data_length); break;
+    case ATCA_INFO:         exec_us = cmd_info(param1); break;
+    case ATCA_SHA:          exec_us = cmd_sha(param1, data, data_length); break;
+    case ATCA_SECUREBOOT:   exec_us = cmd_secureboot(param1, param2, data, data_length); break;
+    default:
+        set_status(SIM_STATUS_PARSE_ERROR);
+        exec_us = 100;
+        break;
+    }
+
+    sim.stats.commands++;
+    sim.stats.opcode_count[opcode]++;
+    sim.stats.exec_ns += exec_us * 1000ull;
+    sim.busy_until_ns = bench_clock_now_ns() + exec_us * 1000ull;
+}
+
+/** \brief Returns true when the device can respond on the bus. */
+static bool device_present(uint8_t address)
+{
+    uint64_t now = bench_clock_now_ns();
+
+    if (sim.state == SIM_STATE_AWAKE && (now - sim.wake_ns) >= ATECC608A_SIM_WATCHDOG_NS)
+    {
+        /* Watchdog expired, the device went back to sleep */
+        sim.state = SIM_STATE_SLEEP;
+        sim.temp_key.valid = 0;
+    }
+    if ((address != device_address()) || (sim.state != SIM_STATE_AWAKE) || (now < sim.busy_until_ns))
+    {
+        sim.stats.nacks++;
+        return false;
+    }
+    return true;
+}
+
+/** \brief Resets the device to the given configuration zone with an empty data zone.
+ *  \param[in] config  128 byte configuration zone image, lock bytes included
+ */
+void atecc608a_sim_init(const uint8_t* config)
+{
+    if (sim.sha_ctx == NULL)
+    {
+        sim.sha_ctx = EVP_MD_CTX_new();
+    }
+    memcpy(sim.config, config, sizeof(sim.config));
+    memset(sim.otp, 0xFF, sizeof(sim.otp));
+    memset(sim.slots, 0xFF, sizeof(sim.slots));
+    sim.rng_state = 0x6A09E667F3BCC908ull;
+    atecc608a_sim_power_cycle();
+    atecc608a_sim_clear_stats();
+}
+
+/** \brief Selects the execution time table. */
+void atecc608a_sim_set_timing(atecc608a_sim_timing timing)
+{
+    sim.timing = timing;
+}
+
+/** \brief Provisions slot contents directly, bypassing lock checks. */
+void atecc608a_sim_write_slot(uint8_t slot, size_t offset, const uint8_t* data, size_t length)
+{
+    if ((slot < ATECC608A_SIM_SLOT_COUNT) && (offset + length <= slot_size(slot)))
+    {
+        memcpy(&sim.slots[slot][offset], data, length);
+    }
+}
+
+void atecc608a_sim_lock_config(void)
+{
+    sim.config[SIM_CFG_LOCK_CONFIG] = 0x00;
+}
+
+void atecc608a_sim_lock_data(void)
+{
+    sim.config[SIM_CFG_LOCK_VALUE] = 0x00;
+}
+
+void atecc608a_sim_lock_slot(uint8_t slot)
+{
+    sim.config[SIM_CFG_SLOT_LOCKED + (slot / 8)] &= ~(1u << (slot % 8));
+}
+
+/** \brief Models a power-on reset: device asleep, volatile state cleared. */
+void atecc608a_sim_power_cycle(void)
+{
+    sim.state = SIM_STATE_SLEEP;
+    sim.busy_until_ns = 0;
+    sim.response_length = 0;
+    sim.response_offset = 0;
+    memset(&sim.temp_key, 0, sizeof(sim.temp_key));
+}
+
+/** \brief Applies a wake pulse to SDA.
+ *  \param[in] low_time_ns  Time SDA is held low
+ *  \return true if the device is awake afterwards
+ */
+bool atecc608a_sim_i2c_wake(uint64_t low_time_ns)
+{
+    if (low_time_ns >= ATECC608A_SIM_WAKE_LOW_NS)
+    {
+        if (sim.state != SIM_STATE_AWAKE)
+        {
+            if (sim.state == SIM_STATE_SLEEP)
+            {
+                sim.temp_key.valid = 0;
+            }
+            sim.state = SIM_STATE_AWAKE;
+            sim.wake_ns = bench_clock_now_ns();
+            sim.busy_until_ns = sim.wake_ns + ATECC608A_SIM_WAKE_HIGH_NS;
+            sim.stats.wakes++;
+            set_status(SIM_STATUS_AFTER_WAKE);
+        }
+    }
+    return sim.state == SIM_STATE_AWAKE;
+}
+
+/** \brief I2C write transaction.
+ *  \return true if the device acknowledged its address
+ */
+bool atecc608a_sim_i2c_write(uint8_t address, const uint8_t* data, size_t length)
+{
+    if (!device_present(address) || length == 0)
+    {
+        return false;
+    }
+
+    switch (data[0])
+    {
+    case SIM_WORD_ADDRESS_RESET:
+        sim.response_offset = 0;
+        break;
+
+    case SIM_WORD_ADDRESS_SLEEP:
+        sim.state = SIM_STATE_SLEEP;
+        sim.temp_key.valid = 0;
+        break;
+
+    case SIM_WORD_ADDRESS_IDLE:
+        sim.state = SIM_STATE_IDLE;
+        break;
+
+    case SIM_WORD_ADDRESS_COMMAND:
+        execute_command(&data[1], length - 1);
+        break;
+
+    default:
+        break;
+    }
+
+    return true;
+}
+
+/** \brief I2C read transaction.
+ *  \return true if the device acknowledged its address
+ */
+bool atecc608a_sim_i2c_read(uint8_t address, uint8_t* data, size_t length)
+{
+    if (!device_present(address))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+        data[i] = (sim.response_offset < sim.response_length) ? sim.response[sim.response_offset++] : 0xFF;
+    }
+
+    return true;
+}
+
+const atecc608a_sim_stats* atecc608a_sim_get_stats(void)
+{
+    return &sim.stats;
+}
+
+void atecc608a_sim_clear_stats(void)
+{
+    memset(&sim.stats, 0, sizeof(sim.stats));
+}
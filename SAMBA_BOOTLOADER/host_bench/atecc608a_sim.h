@@ -0,0 +1,88 @@
+/**
+ * \file
+ *
+ * \brief Transaction level ATECC608A model for the secure boot bench.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef ATECC608A_SIM_H
+#define ATECC608A_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ATECC608A_SIM_CONFIG_SIZE       128
+#define ATECC608A_SIM_SLOT_COUNT        16
+#define ATECC608A_SIM_DEFAULT_ADDRESS   0xC0
+
+/** Minimum SDA low time that wakes the device (tWLO) */
+#define ATECC608A_SIM_WAKE_LOW_NS       60000ull
+/** Time from wake until the device accepts I/O (tWHI) */
+#define ATECC608A_SIM_WAKE_HIGH_NS      1500000ull
+/** Device falls asleep this long after wake (tWATCHDOG) */
+#define ATECC608A_SIM_WATCHDOG_NS       1300000000ull
+
+/** \brief Command execution time table used by the model */
+typedef enum
+{
+    ATECC608A_SIM_TIMING_TYPICAL,
+    ATECC608A_SIM_TIMING_MAX
+} atecc608a_sim_timing;
+
+/** \brief Bus level activity counters */
+typedef struct
+{
+    uint32_t wakes;
+    uint32_t nacks;
+    uint32_t commands;
+    uint32_t opcode_count[256];
+    uint64_t exec_ns;
+} atecc608a_sim_stats;
+
+void atecc608a_sim_init(const uint8_t* config);
+void atecc608a_sim_set_timing(atecc608a_sim_timing timing);
+void atecc608a_sim_write_slot(uint8_t slot, size_t offset, const uint8_t* data, size_t length);
+void atecc608a_sim_lock_config(void);
+void atecc608a_sim_lock_data(void);
+void atecc608a_sim_lock_slot(uint8_t slot);
+void atecc608a_sim_power_cycle(void);
+
+bool atecc608a_sim_i2c_wake(uint64_t low_time_ns);
+bool atecc608a_sim_i2c_write(uint8_t address, const uint8_t* data, size_t length);
+bool atecc608a_sim_i2c_read(uint8_t address, uint8_t* data, size_t length);
+
+const atecc608a_sim_stats* atecc608a_sim_get_stats(void);
+void atecc608a_sim_clear_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * \file
+ *
+ * \brief Virtual time base for the host secure boot bench.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <time.h>
+#include "bench_clock.h"
+
+/** Core clock the CPU scale is given for, OSC8M */
+#define BENCH_CLOCK_BASE_CPU_HZ     8000000UL
+
+static uint64_t modelled_ns;
+static uint64_t cpu_ns;
+static uint64_t cpu_mark_ns;
+static int pause_depth;
+static double cpu_scale = 1.0;
+static uint32_t cpu_hz = BENCH_CLOCK_BASE_CPU_HZ;
+
+static uint64_t host_cpu_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/** \brief Restarts both clock components from zero. */
+void bench_clock_reset(void)
+{
+    modelled_ns = 0;
+    cpu_ns = 0;
+    pause_depth = 0;
+    cpu_mark_ns = host_cpu_ns();
+}
+
+/** \brief Sets the MCU/host speed ratio applied to measured CPU time. */
+void bench_clock_set_cpu_scale(double scale)
+{
+    cpu_scale = scale;
+}
+
+/** \brief Sets the modelled core clock, MCU time shrinks with it. */
+void bench_clock_set_cpu_hz(uint32_t hz)
+{
+    cpu_hz = hz;
+}
+
+/** \brief Returns the modelled core clock. */
+uint32_t bench_clock_cpu_hz(void)
+{
+    return cpu_hz;
+}
+
+/** \brief Stops charging host CPU time to the MCU. Calls nest. */
+void bench_clock_pause(void)
+{
+    if (pause_depth++ == 0)
+    {
+        cpu_ns += host_cpu_ns() - cpu_mark_ns;
+    }
+}
+
+/** \brief Resumes charging host CPU time to the MCU. */
+void bench_clock_resume(void)
+{
+    if (--pause_depth == 0)
+    {
+        cpu_mark_ns = host_cpu_ns();
+    }
+}
+
+/** \brief Charges host CPU time to the MCU again from inside paused code, for
+ *         firmware work done during a modelled wait.
+ *  \return Pause depth to hand back to bench_clock_leave_mcu()
+ */
+int bench_clock_enter_mcu(void)
+{
+    int depth = pause_depth;
+
+    if (depth > 0)
+    {
+        pause_depth = 0;
+        cpu_mark_ns = host_cpu_ns();
+    }
+    return depth;
+}
+
+/** \brief Restores the pause depth saved by bench_clock_enter_mcu(). */
+void bench_clock_leave_mcu(int depth)
+{
+    if (depth > 0)
+    {
+        cpu_ns += host_cpu_ns() - cpu_mark_ns;
+        pause_depth = depth;
+    }
+}
+
+/** \brief Advances the modelled time component. */
+void bench_clock_advance_ns(uint64_t ns)
+{
+    modelled_ns += ns;
+}
+
+/** \brief Returns the scaled MCU CPU time consumed so far. */
+uint64_t bench_clock_cpu_ns(void)
+{
+    uint64_t ns = cpu_ns;
+
+    if (pause_depth == 0)
+    {
+        ns += host_cpu_ns() - cpu_mark_ns;
+    }
+    return (uint64_t)((double)ns * cpu_scale * BENCH_CLOCK_BASE_CPU_HZ / cpu_hz);
+}
+
+/** \brief Returns the modelled time consumed so far. */
+uint64_t bench_clock_modelled_ns(void)
+{
+    return modelled_ns;
+}
+
+/** \brief Returns the current bench time. */
+uint64_t bench_clock_now_ns(void)
+{
+    return bench_clock_modelled_ns() + bench_clock_cpu_ns();
+}
@@ -0,0 +1,66 @@
+/**
+ * \file
+ *
+ * \brief Virtual time base for the host secure boot bench.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef BENCH_CLOCK_H
+#define BENCH_CLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*
+ * Bench time is the sum of two components:
+ *  - modelled time: I2C bus transfers, device execution and HAL delays, which
+ *    advance the clock explicitly through bench_clock_advance_ns();
+ *  - MCU time: host CPU time spent in bootloader/cryptoauthlib code, scaled by
+ *    bench_clock_set_cpu_scale() to approximate the SAMD21 at 8 MHz, and by
+ *    the core clock set with bench_clock_set_cpu_hz().
+ * Code that models hardware (the device simulator, the HAL glue) runs with the
+ * CPU component paused so its own host cost is not charged to the MCU.
+ */
+void bench_clock_reset(void);
+void bench_clock_set_cpu_scale(double scale);
+void bench_clock_set_cpu_hz(uint32_t hz);
+uint32_t bench_clock_cpu_hz(void);
+void bench_clock_pause(void);
+void bench_clock_resume(void);
+void bench_clock_advance_ns(uint64_t ns);
+uint64_t bench_clock_now_ns(void);
+uint64_t bench_clock_modelled_ns(void);
+uint64_t bench_clock_cpu_ns(void);
+int bench_clock_enter_mcu(void);
+void bench_clock_leave_mcu(int depth);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
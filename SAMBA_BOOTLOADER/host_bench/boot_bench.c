@@ -0,0 +1,501 @@
+/**
+ * \file
+ *
+ * \brief Host benchmark of the bootloader secure boot verification path.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ecdsa.h>
+#include <openssl/bn.h>
+#include <openssl/x509.h>
+#include <asf.h>
+#include "cryptoauthlib.h"
+#include "secure_boot.h"
+#include "memory_conf.h"
+#include "crypto_device_app.h"
+#include "secure_boot_app.h"
+#include "secure_boot_partition.h"
+#include "secure_boot_slot.h"
+#include "boot_trace.h"
+#include "atecc608a_sim.h"
+#include "nvm_host.h"
+#include "bench_clock.h"
+#include "hal_i2c_sim.h"
+#include "crypto_device_poll.h"
+
+#define BENCH_DEFAULT_IMAGE         "../../PythonScripts/FREERTOS_OLED1_XPRO_EXAMPLE1.bin"
+#define BENCH_DEFAULT_KEY           "../../PythonScripts/key.pem"
+#define BENCH_DEFAULT_BOOTS         3
+#define BENCH_SECURE_BOOT_PUBKEY_SLOT   15
+#define BENCH_SECURE_BOOT_SIGDIG_SLOT   9
+/** Used image length alignment of the application linker script */
+#define BENCH_IMAGE_ALIGN           1024
+
+/* Configuration loaded by PythonScripts/sboot_provisioning.py, zones unlocked */
+static const uint8_t bench_sboot_config[ATECC608A_SIM_CONFIG_SIZE] = {
+    0x01, 0x23, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x00,
+    0x5A, 0x00, 0x00, 0x01, 0x85, 0x00, 0x82, 0x00,  0x85, 0x20, 0x85, 0x20, 0x85, 0x20, 0x8F, 0x46,
+    0x8F, 0x0F, 0x8F, 0x0F, 0x0F, 0x0F, 0x9F, 0x8F,  0x0F, 0x8F, 0x0F, 0x8F, 0x0F, 0x8F, 0x0F, 0x0F,
+    0x0D, 0x1F, 0x0F, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF,  0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF9,  0x00, 0x69, 0x76, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x55, 0x55,  0xFF, 0xFF, 0x0E, 0x60, 0x00, 0x00, 0x00, 0x00,
+    0x53, 0x00, 0x53, 0x00, 0x73, 0x00, 0x73, 0x00,  0x73, 0x00, 0x38, 0x00, 0x7C, 0x00, 0x1A, 0x00,
+    0x3C, 0x00, 0x1C, 0x00, 0x1C, 0x00, 0x10, 0x00,  0x1C, 0x00, 0x30, 0x00, 0x12, 0x00, 0x30, 0x00,
+};
+
+static const char* const secure_boot_mode_names[] = { "Disabled", "FullBoth", "FullSig", "FullDig" };
+static const char* const digest_engine_names[] = { "-", "host", "atecc" };
+
+/** \brief Bench time of each trace phase for the current boot */
+static struct
+{
+    uint64_t ns[BOOT_TRACE_PHASE_COUNT];
+    bool     seen[BOOT_TRACE_PHASE_COUNT];
+    uint32_t probes;
+} trace;
+
+/** \brief Host implementation of the bootloader trace hook. */
+void boot_trace_record(boot_trace_phase phase, uint32_t arg)
+{
+    bench_clock_pause();
+    if (phase < BOOT_TRACE_PHASE_COUNT)
+    {
+        trace.ns[phase] = bench_clock_now_ns();
+        trace.seen[phase] = true;
+        if (phase == BOOT_TRACE_PROBE_ADDRESS)
+        {
+            trace.probes++;
+        }
+    }
+    bench_clock_resume();
+}
+
+/** \brief Host implementation of the trace clock, bench time since start */
+uint32_t boot_trace_now_us(void)
+{
+    return (uint32_t)(bench_clock_now_ns() / 1000);
+}
+
+/** \brief Prints the time from the later of from/after to to. With the
+ *         pipelined digest phases overlap, a phase that ends before it starts
+ *         is printed as '-'.
+ */
+static void print_phase_after(boot_trace_phase from, boot_trace_phase after, boot_trace_phase to)
+{
+    uint64_t start_ns = trace.ns[from];
+
+    if (trace.seen[after] && (trace.ns[after] > start_ns))
+    {
+        start_ns = trace.ns[after];
+    }
+
+    if (trace.seen[from] && trace.seen[to] && (trace.ns[to] >= start_ns))
+    {
+        printf(" %10.3f", (trace.ns[to] - start_ns) / 1e6);
+    }
+    else
+    {
+        printf(" %10s", "-");
+    }
+}
+
+static void print_phase(boot_trace_phase from, boot_trace_phase to)
+{
+    print_phase_after(from, from, to);
+}
+
+/** \brief Prints the command latencies the I2C HAL learned over all boots */
+static void print_poll_table(void)
+{
+    uint8_t count;
+    const crypto_device_poll_entry* entry = crypto_device_poll_table(&count);
+
+    printf("\nopcode variant %6s %6s %8s %12s %10s %10s %10s\n",
+           "done", "polls", "timeouts", "estimate(us)", "min(us)", "max(us)", "limit(us)");
+    for (; count > 0; count--, entry++)
+    {
+        if (entry->completions == 0 && entry->timeouts == 0)
+        {
+            continue;
+        }
+        printf("  0x%02X %7u %6u %6u %8u %12lu %10lu %10lu %10lu\n", entry->opcode, entry->variant,
+               entry->completions, entry->polls, entry->timeouts, (unsigned long)entry->estimate_us,
+               (unsigned long)entry->min_seen_us, (unsigned long)entry->max_seen_us, (unsigned long)entry->max_us);
+    }
+}
+
+/** \brief Records the used image length in the footer the way the application
+ *         linker script does: up to the last byte that is not erased or zero,
+ *         rounded up to 1 KB, plus the footer.
+ */
+static void trim_image(void)
+{
+    memory_parameters* footer = (memory_parameters*)nvm_host_flash(USER_APPLICATION_HEADER_ADDRESS);
+    const uint8_t* image = nvm_host_flash(USER_APPLICATION_START_ADDRESS);
+    uint32_t length = USER_APPLICATION_HEADER_ADDRESS - USER_APPLICATION_START_ADDRESS;
+
+    while ((length > 0) && ((image[length - 1] == 0xFF) || (image[length - 1] == 0x00)))
+    {
+        length--;
+    }
+    length = (length + BENCH_IMAGE_ALIGN - 1) & ~(BENCH_IMAGE_ALIGN - 1);
+    if (length > (USER_APPLICATION_HEADER_ADDRESS - USER_APPLICATION_START_ADDRESS))
+    {
+        length = USER_APPLICATION_HEADER_ADDRESS - USER_APPLICATION_START_ADDRESS;
+    }
+    footer->memory_size = length + USER_APPLICATION_HEADER_SIZE;
+}
+
+/** \brief Lists a data partition of length bytes at the start of the partition
+ *         area in the footer and fills it with pseudo-random data.
+ */
+static bool add_partition(uint32_t length)
+{
+    memory_parameters* footer = (memory_parameters*)nvm_host_flash(USER_APPLICATION_HEADER_ADDRESS);
+    secure_boot_partition_manifest* manifest = (secure_boot_partition_manifest*)footer->reserved;
+    uint8_t* data = nvm_host_flash(SECURE_BOOT_PARTITION_START_ADDRESS);
+    uint32_t i;
+
+    if ((length == 0) || (length > (SECURE_BOOT_PARTITION_END_ADDRESS - SECURE_BOOT_PARTITION_START_ADDRESS)))
+    {
+        return false;
+    }
+    for (i = 0; i < length; i++)
+    {
+        data[i] = (uint8_t)rand();
+    }
+
+    memset(manifest, 0xFF, sizeof(*manifest));
+    memcpy(manifest->magic, "PART", sizeof(manifest->magic));
+    manifest->count = 1;
+    manifest->regions[0].address = SECURE_BOOT_PARTITION_START_ADDRESS;
+    manifest->regions[0].length = length;
+
+    return true;
+}
+
+/** \brief Returns the footer of the slot starting at slot_address */
+static memory_parameters* slot_footer(uint32_t slot_address)
+{
+    return (memory_parameters*)nvm_host_flash(slot_address + USER_APPLICATION_SLOT_SIZE - USER_APPLICATION_HEADER_SIZE);
+}
+
+/** \brief Signs the image in a slot the same way sboot_sign_firmware.py does
+ *         and returns the signer's public key. The signed data is the image
+ *         length from the footer, the partitions the footer lists and the
+ *         footer up to the signature.
+ *  \param[in]  slot_address Start of the slot holding the image
+ *  \param[in]  key_file    PEM private key
+ *  \param[out] public_key  X and Y, 64 bytes
+ *  \return true on success
+ */
+static bool sign_image(uint32_t slot_address, const char* key_file, uint8_t* public_key)
+{
+    memory_parameters* footer = slot_footer(slot_address);
+    static uint8_t signed_data[NVMCTRL_FLASH_SIZE];
+    const secure_boot_partition_manifest* partitions = (const secure_boot_partition_manifest*)footer->reserved;
+    uint32_t signed_length = footer->memory_size - ATCA_SIG_SIZE;
+    uint32_t image_length = signed_length - USER_APPLICATION_FOOTER_SIGNED_SIZE;
+    uint8_t digest[ATCA_SHA_DIGEST_SIZE];
+    uint8_t der_sig[80];
+    size_t der_sig_length = sizeof(der_sig);
+    const uint8_t* der_sig_ptr = der_sig;
+    uint8_t* spki = NULL;
+    int spki_length;
+    EVP_PKEY* pkey = NULL;
+    EVP_PKEY_CTX* ctx = NULL;
+    ECDSA_SIG* sig = NULL;
+    const BIGNUM* r;
+    const BIGNUM* s;
+    FILE* fp;
+    bool success = false;
+
+    if ((fp = fopen(key_file, "r")) == NULL)
+    {
+        fprintf(stderr, "cannot open key %s\n", key_file);
+        return false;
+    }
+    pkey = PEM_read_PrivateKey(fp, NULL, NULL, NULL);
+    fclose(fp);
+
+    do
+    {
+        if ((pkey == NULL) || (signed_length < USER_APPLICATION_FOOTER_SIGNED_SIZE) ||
+            (image_length > (USER_APPLICATION_SLOT_SIZE - USER_APPLICATION_HEADER_SIZE)))
+        {
+            break;
+        }
+        memcpy(signed_data, nvm_host_flash(slot_address), image_length);
+        signed_length = image_length;
+        if (memcmp(partitions->magic, "PART", sizeof(partitions->magic)) == 0)
+        {
+            for (uint8_t i = 0; i < partitions->count; i++)
+            {
+                memcpy(&signed_data[signed_length], nvm_host_flash(partitions->regions[i].address), partitions->regions[i].length);
+                signed_length += partitions->regions[i].length;
+            }
+        }
+        memcpy(&signed_data[signed_length], footer, USER_APPLICATION_FOOTER_SIGNED_SIZE);
+        signed_length += USER_APPLICATION_FOOTER_SIGNED_SIZE;
+        if (!EVP_Digest(signed_data, signed_length, digest, NULL, EVP_sha256(), NULL))
+        {
+            break;
+        }
+        if ((ctx = EVP_PKEY_CTX_new(pkey, NULL)) == NULL || EVP_PKEY_sign_init(ctx) <= 0 ||
+            EVP_PKEY_sign(ctx, der_sig, &der_sig_length, digest, sizeof(digest)) <= 0)
+        {
+            break;
+        }
+        if ((sig = d2i_ECDSA_SIG(NULL, &der_sig_ptr, der_sig_length)) == NULL)
+        {
+            break;
+        }
+        ECDSA_SIG_get0(sig, &r, &s);
+        BN_bn2binpad(r, &footer->signature[0], 32);
+        BN_bn2binpad(s, &footer->signature[32], 32);
+
+        /* Uncompressed point is the tail of the SubjectPublicKeyInfo */
+        if ((spki_length = i2d_PUBKEY(pkey, &spki)) < ATCA_PUB_KEY_SIZE)
+        {
+            break;
+        }
+        memcpy(public_key, &spki[spki_length - ATCA_PUB_KEY_SIZE], ATCA_PUB_KEY_SIZE);
+        success = true;
+    }
+    while (0);
+
+    OPENSSL_free(spki);
+    ECDSA_SIG_free(sig);
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(pkey);
+
+    return success;
+}
+
+/** \brief Loads a provisioned, locked device matching the compiled secure boot mode. */
+static void provision_device(uint8_t i2c_address, const uint8_t* public_key)
+{
+    uint8_t config[ATECC608A_SIM_CONFIG_SIZE];
+    uint8_t public_key_slot_data[72];
+
+    memcpy(config, bench_sboot_config, sizeof(config));
+    config[16] = i2c_address;
+    config[SECUREBOOTCONFIG_OFFSET] = SECURE_BOOT_CONFIGURATION;
+    config[SECUREBOOTCONFIG_OFFSET + 1] = (BENCH_SECURE_BOOT_PUBKEY_SLOT << 4) | BENCH_SECURE_BOOT_SIGDIG_SLOT;
+
+    atecc608a_sim_init(config);
+    atecc608a_sim_lock_config();
+    atecc608a_sim_lock_data();
+
+    memset(public_key_slot_data, 0, sizeof(public_key_slot_data));
+    memcpy(&public_key_slot_data[4], &public_key[0], 32);
+    memcpy(&public_key_slot_data[40], &public_key[32], 32);
+    atecc608a_sim_write_slot(BENCH_SECURE_BOOT_PUBKEY_SLOT, 0, public_key_slot_data, sizeof(public_key_slot_data));
+    atecc608a_sim_lock_slot(BENCH_SECURE_BOOT_PUBKEY_SLOT);
+
+#if SECURE_BOOT_CONFIGURATION == SECURE_BOOT_CONFIG_FULL_SIGN
+    /* FullSig parts are provisioned with the signature of the shipped image */
+    atecc608a_sim_write_slot(BENCH_SECURE_BOOT_SIGDIG_SLOT, 0,
+                             ((memory_parameters*)nvm_host_flash(USER_APPLICATION_HEADER_ADDRESS))->signature, ATCA_SIG_SIZE);
+#endif
+}
+
+static void usage(const char* name)
+{
+    printf("usage: %s [-i image.bin] [-k key.pem] [-n boots] [-u boot] [-a i2c_address] [-s cpu_scale] [-m] [-S] [-t] [-P length] [-f mhz] [-b] [-x boot]\n"
+           "  -i  application image loaded at 0x%05X (default %s)\n"
+           "  -k  signing key, the image footer is re-signed with it (default %s)\n"
+           "  -n  number of consecutive boots (default %d)\n"
+           "  -u  bump the footer version and re-sign the image before this boot (default none)\n"
+           "  -a  8-bit I2C address of the device (default 0x5A)\n"
+           "  -s  MCU/host speed ratio applied to measured CPU time (default 1.0)\n"
+           "  -m  use maximum instead of typical device execution times\n"
+           "  -S  serial boot, no hashing during device delays (baseline for hidden(ms))\n"
+           "  -t  record the used image length in the footer instead of the whole region\n"
+           "  -P  sign a data partition of this many bytes at 0x%05X with the image\n"
+           "  -f  core clock of the verification in MHz, 48 for the boost clock (default 8)\n"
+           "  -b  with -u, write the update to slot B at 0x%05X, slot A keeps the old image\n"
+           "  -x  corrupt the image in slot B before this boot, the slot column shows the fallback\n",
+           name, APP_START_ADDRESS, BENCH_DEFAULT_IMAGE, BENCH_DEFAULT_KEY, BENCH_DEFAULT_BOOTS,
+           SECURE_BOOT_PARTITION_START_ADDRESS, USER_APPLICATION_SLOT_B_ADDRESS);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* image_file = BENCH_DEFAULT_IMAGE;
+    const char* key_file = BENCH_DEFAULT_KEY;
+    int boots = BENCH_DEFAULT_BOOTS;
+    int update_boot = 0;
+    bool trim = false;
+    bool update_slot_b = false;
+    int corrupt_boot = 0;
+    uint32_t update_slot = USER_APPLICATION_START_ADDRESS;
+    uint32_t partition_length = 0;
+    uint8_t i2c_address = 0x5A;
+    double cpu_scale = 1.0;
+    uint32_t cpu_mhz = 8;
+    atecc608a_sim_timing timing = ATECC608A_SIM_TIMING_TYPICAL;
+    bool overlap = true;
+    static uint8_t image[USER_APPLICATION_END_ADDRESS - USER_APPLICATION_START_ADDRESS + NVMCTRL_ROW_SIZE];
+    uint8_t public_key[ATCA_PUB_KEY_SIZE];
+    size_t image_length;
+    FILE* fp;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:k:n:u:a:s:mStP:f:bx:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i': image_file = optarg; break;
+        case 'k': key_file = optarg; break;
+        case 'n': boots = atoi(optarg); break;
+        case 'u': update_boot = atoi(optarg); break;
+        case 'a': i2c_address = (uint8_t)strtoul(optarg, NULL, 0); break;
+        case 's': cpu_scale = atof(optarg); break;
+        case 'm': timing = ATECC608A_SIM_TIMING_MAX; break;
+        case 'S': overlap = false; break;
+        case 't': trim = true; break;
+        case 'P': partition_length = strtoul(optarg, NULL, 0); break;
+        case 'f': cpu_mhz = strtoul(optarg, NULL, 0); break;
+        case 'b': update_slot_b = true; break;
+        case 'x': corrupt_boot = atoi(optarg); break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    if ((fp = fopen(image_file, "rb")) == NULL)
+    {
+        fprintf(stderr, "cannot open image %s\n", image_file);
+        return 1;
+    }
+    image_length = fread(image, 1, sizeof(image), fp);
+    fclose(fp);
+
+    nvm_host_reset();
+    nvm_host_load(USER_APPLICATION_START_ADDRESS, image, image_length);
+    if (trim)
+    {
+        trim_image();
+    }
+    if (partition_length && !add_partition(partition_length))
+    {
+        fprintf(stderr, "cannot add a partition of %lu bytes\n", (unsigned long)partition_length);
+        return 1;
+    }
+    if (!sign_image(USER_APPLICATION_START_ADDRESS, key_file, public_key))
+    {
+        fprintf(stderr, "cannot sign image with %s\n", key_file);
+        return 1;
+    }
+
+    provision_device(i2c_address, public_key);
+    atecc608a_sim_set_timing(timing);
+    bench_clock_set_cpu_scale(cpu_scale);
+    bench_clock_set_cpu_hz((cpu_mhz ? cpu_mhz : 8) * 1000000UL);
+    hal_i2c_sim_set_overlap(overlap);
+    srand(1);
+
+    printf("secure boot bench: mode %s, device 0x%02X, %s device timing, cpu scale %.2f at %lu MHz, %s digest\n",
+           secure_boot_mode_names[SECURE_BOOT_CONFIGURATION], i2c_address,
+           (timing == ATECC608A_SIM_TIMING_MAX) ? "max" : "typical", cpu_scale,
+           (unsigned long)(bench_clock_cpu_hz() / 1000000UL),
+           overlap ? "pipelined" : "serial");
+    printf("image %s, %lu bytes, %lu signed\n\n", image_file, (unsigned long)image_length,
+           (unsigned long)(((memory_parameters*)nvm_host_flash(USER_APPLICATION_HEADER_ADDRESS))->memory_size - ATCA_SIG_SIZE));
+    printf("boot status %10s %10s %10s %10s %10s %10s %10s %10s %6s %6s %6s %6s %4s\n",
+           "probe(ms)", "locks(ms)", "setup(ms)", "digest(ms)", "verify(ms)", "total(ms)", "cpu(ms)", "hidden(ms)",
+           "probes", "cmds", "nacks", "engine", "slot");
+    nvm_host_clear_stats();
+
+    for (int boot = 1; boot <= boots; boot++)
+    {
+        ATCA_STATUS status;
+        const atecc608a_sim_stats* sim_stats = atecc608a_sim_get_stats();
+
+        if (boot == update_boot)
+        {
+            /* New release: bump the footer version and re-sign. Into slot B
+             * it is a copy of slot A with the footer start address of slot B
+             * (not relinked, the bench does not execute it) */
+            if (update_slot_b)
+            {
+                update_slot = USER_APPLICATION_SLOT_B_ADDRESS;
+                memcpy(nvm_host_flash(update_slot), nvm_host_flash(USER_APPLICATION_START_ADDRESS), USER_APPLICATION_SLOT_SIZE);
+                slot_footer(update_slot)->start_address = update_slot;
+            }
+            slot_footer(update_slot)->version_info++;
+            if (!sign_image(update_slot, key_file, public_key))
+            {
+                fprintf(stderr, "cannot sign image with %s\n", key_file);
+                return 1;
+            }
+        }
+        if (boot == corrupt_boot)
+        {
+            /* Interrupted or tampered update */
+            nvm_host_flash(USER_APPLICATION_SLOT_B_ADDRESS)[0] ^= 0x01;
+        }
+        atecc608a_sim_power_cycle();
+        atecc608a_sim_clear_stats();
+        memset(&trace, 0, sizeof(trace));
+        bench_clock_reset();
+        hal_i2c_sim_clear_overlap();
+
+        /* As main.c, the slot with the newest image is verified first */
+        secure_boot_slot_select_first();
+        status = crypto_device_verify_app();
+
+        bench_clock_pause();
+        printf("%4d   0x%02X", boot, status);
+        print_phase(BOOT_TRACE_VERIFY_START, BOOT_TRACE_PROBE_DONE);
+        print_phase(BOOT_TRACE_PROBE_DONE, BOOT_TRACE_LOCK_CHECK_DONE);
+        print_phase(BOOT_TRACE_LOCK_CHECK_DONE, BOOT_TRACE_DIGEST_START);
+        print_phase(BOOT_TRACE_DIGEST_START, BOOT_TRACE_DIGEST_DONE);
+        print_phase_after(BOOT_TRACE_DIGEST_DONE, BOOT_TRACE_LOCK_CHECK_DONE, BOOT_TRACE_VERIFY_DONE);
+        printf(" %10.3f %10.3f %10.3f %6lu %6lu %6lu %6s", bench_clock_now_ns() / 1e6, bench_clock_cpu_ns() / 1e6,
+               hal_i2c_sim_overlap_ns() / 1e6,
+               (unsigned long)trace.probes, (unsigned long)sim_stats->commands, (unsigned long)sim_stats->nacks,
+               digest_engine_names[secure_boot_app_get_digest_engine()]);
+        printf(" %4s\n", (status != ATCA_SUCCESS) ? "-" : (secure_boot_slot_selected() == SECURE_BOOT_SLOT_A) ? "A" : "B");
+        bench_clock_resume();
+
+        atcab_release();
+    }
+
+    /* State the bootloader keeps in flash goes through the boot journal */
+    printf("\nflash: %lu page writes, %lu row erases over %d boots\n",
+           (unsigned long)nvm_host_get_stats()->page_writes, (unsigned long)nvm_host_get_stats()->row_erases, boots);
+
+    print_poll_table();
+
+    return 0;
+}
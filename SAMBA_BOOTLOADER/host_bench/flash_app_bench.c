@@ -0,0 +1,388 @@
+/**
+ * \file
+ *
+ * \brief Host checks of the flash applet programming decisions.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <asf.h>
+#include "nvm_host.h"
+#include "nvm_async_host.h"
+#include "flash_app_ops.h"
+#include "../common/applet.h"
+
+/*
+ * Runs the peripheral free part of the flash applet (flash_app_ops.c) against
+ * the flash model and the host job queue, and checks which rows it erases
+ * and which pages it programs.
+ */
+
+#define BENCH_ROW_ADDRESS           0x8000
+
+static int failures;
+/** Completion callbacks of the jobs queued by applet_row_queue() */
+static uint32_t callbacks;
+
+/** DSU model: refuses the area when dsu.refuse is set, like a protected device */
+static struct
+{
+    bool refuse;
+    uint32_t calls;
+    uint32_t length;
+} dsu;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+static void check(bool ok, const char* condition, int line)
+{
+    if (!ok)
+    {
+        printf("    FAIL line %d: %s\n", line, condition);
+        failures++;
+    }
+}
+
+static void count_callback(enum status_code status, void* context)
+{
+    (void)status;
+    (void)context;
+    callbacks++;
+}
+
+/** \brief Host DSU for applet_crc32(), a running CRC32 over whole words. */
+bool applet_crc32_dsu(uint32_t address, uint32_t length, uint32_t* crc)
+{
+    const uint8_t* data = nvm_host_flash(address);
+    uint32_t i;
+    uint8_t bit;
+
+    dsu.calls++;
+    dsu.length = length;
+    if (dsu.refuse || (address & 3) || (length & 3))
+    {
+        return false;
+    }
+    for (i = 0; i < length; i++)
+    {
+        *crc ^= data[i];
+        for (bit = 0; bit < 8; bit++)
+        {
+            *crc = (*crc & 1) ? (*crc >> 1) ^ 0xEDB88320 : (*crc >> 1);
+        }
+    }
+    return true;
+}
+
+/** \brief Table driven CRC32 as zlib computes it, independent of the applet. */
+static uint32_t crc32_reference(const uint8_t* data, uint32_t length)
+{
+    static uint32_t table[256];
+    uint32_t crc = 0xFFFFFFFF;
+    uint32_t i, j;
+
+    if (table[1] == 0)
+    {
+        for (i = 0; i < 256; i++)
+        {
+            table[i] = i;
+            for (j = 0; j < 8; j++)
+            {
+                table[i] = (table[i] & 1) ? (table[i] >> 1) ^ 0xEDB88320 : (table[i] >> 1);
+            }
+        }
+    }
+    for (i = 0; i < length; i++)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/** \brief Queues a row, drains the queue and checks the row holds the data. */
+static void queue_row(const uint8_t* row, uint32_t erases, uint32_t writes)
+{
+    uint8_t jobs = 0;
+
+    nvm_host_clear_stats();
+    callbacks = 0;
+    CHECK(applet_row_queue(BENCH_ROW_ADDRESS, row, count_callback, &jobs) == STATUS_OK);
+    CHECK(nvm_async_wait() == STATUS_OK);
+    CHECK(jobs == erases + writes);
+    CHECK(callbacks == jobs);
+    CHECK(nvm_host_get_stats()->row_erases == erases);
+    CHECK(nvm_host_get_stats()->page_writes == writes);
+    CHECK(memcmp(nvm_host_flash(BENCH_ROW_ADDRESS), row, NVMCTRL_ROW_SIZE) == 0);
+}
+
+static void test_page_compare(void)
+{
+    uint32_t flash[FLASH_PAGE_SIZE / sizeof(uint32_t)];
+    uint32_t data[FLASH_PAGE_SIZE / sizeof(uint32_t)];
+
+    printf("  applet_page_compare\n");
+
+    memset(flash, 0xFF, sizeof(flash));
+    memcpy(data, flash, sizeof(data));
+    CHECK(applet_page_compare(flash, data) == APPLET_PAGE_SAME);
+
+    /* Clearing bits programs the page in place */
+    data[3] = 0x12345678;
+    CHECK(applet_page_compare(flash, data) == APPLET_PAGE_PROGRAM);
+
+    /* Setting a bit needs the row erased, whatever comes before it */
+    flash[9] = 0x0000FFFF;
+    data[9] = 0x0001FFFF;
+    CHECK(applet_page_compare(flash, data) == APPLET_PAGE_ERASE);
+    data[9] = flash[9];
+    CHECK(applet_page_compare(flash, data) == APPLET_PAGE_PROGRAM);
+    memcpy(flash, data, sizeof(flash));
+    CHECK(applet_page_compare(flash, data) == APPLET_PAGE_SAME);
+}
+
+static void test_row_queue(void)
+{
+    uint8_t row[NVMCTRL_ROW_SIZE] __attribute__((aligned(4)));
+    uint32_t i;
+
+    printf("  applet_row_queue\n");
+
+    nvm_host_reset();
+    nvm_async_init();
+    for (i = 0; i < sizeof(row); i++)
+    {
+        row[i] = (uint8_t)(i * 7);
+    }
+
+    /* A blank row is programmed without an erase */
+    queue_row(row, 0, NVMCTRL_ROW_PAGES);
+
+    /* Writing the same data again queues nothing */
+    queue_row(row, 0, 0);
+
+    /* A page whose data only clears bits is programmed alone */
+    row[2 * FLASH_PAGE_SIZE + 5] &= 0xF0;
+    queue_row(row, 0, 1);
+
+    /* A bit set back to 1 erases the row, then only the pages holding data
+     * are programmed */
+    row[FLASH_PAGE_SIZE + 7] = 0xFF;
+    memset(&row[3 * FLASH_PAGE_SIZE], 0xFF, FLASH_PAGE_SIZE);
+    queue_row(row, 1, NVMCTRL_ROW_PAGES - 1);
+
+    /* Erasing a row back to blank is a single erase */
+    memset(row, 0xFF, sizeof(row));
+    queue_row(row, 1, 0);
+}
+
+static void test_erase_rows(void)
+{
+    const uint32_t start_row = BENCH_ROW_ADDRESS / NVMCTRL_ROW_SIZE;
+    const uint32_t end_row = start_row + 8;
+    uint32_t rows_erased;
+    uint32_t row;
+
+    printf("  applet_row_is_blank, applet_erase_rows\n");
+
+    nvm_host_reset();
+    nvm_async_init();
+    CHECK(applet_row_is_blank(start_row * NVMCTRL_ROW_SIZE));
+
+    /* A single programmed bit, in the last word of a row, makes it not blank */
+    *nvm_host_flash((start_row + 1) * NVMCTRL_ROW_SIZE) = 0x00;
+    *nvm_host_flash((start_row + 4) * NVMCTRL_ROW_SIZE - 1) = 0x7F;
+    *nvm_host_flash((start_row + 7) * NVMCTRL_ROW_SIZE + 100) = 0x55;
+    CHECK(!applet_row_is_blank((start_row + 3) * NVMCTRL_ROW_SIZE));
+    CHECK(applet_row_is_blank((start_row + 4) * NVMCTRL_ROW_SIZE));
+
+    /* Only the rows holding data are erased and counted */
+    nvm_host_clear_stats();
+    CHECK(applet_erase_rows(start_row, end_row, &rows_erased) == STATUS_OK);
+    CHECK(rows_erased == 3);
+    CHECK(nvm_host_get_stats()->row_erases == 3);
+    for (row = start_row; row < end_row; row++)
+    {
+        CHECK(applet_row_is_blank(row * NVMCTRL_ROW_SIZE));
+    }
+
+    /* Erasing a blank area erases nothing */
+    nvm_host_clear_stats();
+    CHECK(applet_erase_rows(start_row, end_row, &rows_erased) == STATUS_OK);
+    CHECK(rows_erased == 0);
+    CHECK(nvm_host_get_stats()->row_erases == 0);
+
+    /* A row that fails to erase fails the whole erase, once the rows after
+     * it are erased too */
+    *nvm_host_flash((start_row + 2) * NVMCTRL_ROW_SIZE) = 0x00;
+    *nvm_host_flash((start_row + 5) * NVMCTRL_ROW_SIZE) = 0x00;
+    nvm_async_host_fail_row((start_row + 2) * NVMCTRL_ROW_SIZE);
+    CHECK(applet_erase_rows(start_row, end_row, &rows_erased) == STATUS_ABORTED);
+    CHECK(rows_erased == 2);
+    CHECK(!applet_row_is_blank((start_row + 2) * NVMCTRL_ROW_SIZE));
+    CHECK(applet_row_is_blank((start_row + 5) * NVMCTRL_ROW_SIZE));
+    nvm_async_init();
+}
+
+static void test_nvm_memcpy(void)
+{
+    uint8_t data[300];
+    uint32_t i;
+
+    printf("  applet_nvm_memcpy\n");
+
+    nvm_host_reset();
+    nvm_async_init();
+    for (i = 0; i < 3 * NVMCTRL_ROW_SIZE; i++)
+    {
+        *nvm_host_flash(BENCH_ROW_ADDRESS + i) = (uint8_t)(i * 7);
+    }
+    for (i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i ^ 0xA5);
+    }
+
+    /* A write across two rows keeps what was around it in both */
+    CHECK(applet_nvm_memcpy(BENCH_ROW_ADDRESS + 100, data, sizeof(data)) == STATUS_OK);
+    CHECK(memcmp(nvm_host_flash(BENCH_ROW_ADDRESS + 100), data, sizeof(data)) == 0);
+    CHECK(*nvm_host_flash(BENCH_ROW_ADDRESS + 99) == (uint8_t)(99 * 7));
+    CHECK(*nvm_host_flash(BENCH_ROW_ADDRESS + 100 + sizeof(data)) == (uint8_t)((100 + sizeof(data)) * 7));
+    CHECK(nvm_async_pending() == 0);
+
+    /* A row that fails to erase fails the write */
+    *nvm_host_flash(BENCH_ROW_ADDRESS + NVMCTRL_ROW_SIZE + 200) = 0x00;
+    nvm_async_host_fail_row(BENCH_ROW_ADDRESS + NVMCTRL_ROW_SIZE);
+    memset(data, 0x5A, sizeof(data));
+    CHECK(applet_nvm_memcpy(BENCH_ROW_ADDRESS, data, sizeof(data)) == STATUS_ABORTED);
+    CHECK(nvm_async_pending() == 0);
+    nvm_async_init();
+}
+
+static void test_crc32(void)
+{
+    static const uint32_t lengths[] = { 0, 1, 3, 4, 5, 7, 64, 255, 1021, 4096 };
+    uint8_t* flash = nvm_host_flash(BENCH_ROW_ADDRESS);
+    uint32_t i, length;
+
+    printf("  applet_crc32\n");
+
+    nvm_host_reset();
+    memcpy(flash, "123456789", 9);
+    CHECK(applet_crc32(BENCH_ROW_ADDRESS, 9) == 0xCBF43926);
+    for (i = 0; i < 4096; i++)
+    {
+        flash[i] = (uint8_t)((i * 131) ^ (i >> 3));
+    }
+
+    for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+    {
+        length = lengths[i];
+
+        /* The DSU gets the whole words, the core the tail */
+        memset(&dsu, 0, sizeof(dsu));
+        CHECK(applet_crc32(BENCH_ROW_ADDRESS, length) == crc32_reference(flash, length));
+        CHECK(dsu.calls == ((length >= 4) ? 1 : 0));
+        CHECK((dsu.calls == 0) || (dsu.length == (length & ~3)));
+
+        /* The core computes the whole area when the DSU refuses it */
+        memset(&dsu, 0, sizeof(dsu));
+        dsu.refuse = true;
+        CHECK(applet_crc32(BENCH_ROW_ADDRESS, length) == crc32_reference(flash, length));
+    }
+    memset(&dsu, 0, sizeof(dsu));
+}
+
+/** Entries of test_batch_run(), each returns the status in its first argument */
+static uint32_t batch_calls;
+
+static void batch_command(struct _BatchEntry* entry)
+{
+    batch_calls++;
+    entry->status = entry->argument[0];
+    entry->argument[1] = batch_calls;
+}
+
+static void test_batch_run(void)
+{
+    struct _BatchEntry entries[4];
+    uint32_t status;
+    uint32_t i;
+
+    printf("  applet_batch_run\n");
+
+    memset(entries, 0, sizeof(entries));
+    for (i = 0; i < 4; i++)
+    {
+        entries[i].command = APPLET_CMD_UNLOCK;
+        entries[i].status = APPLET_FAIL;
+    }
+
+    /* An empty batch succeeds without running anything */
+    batch_calls = 0;
+    CHECK(applet_batch_run(entries, 0, batch_command, &status) == 0);
+    CHECK(status == APPLET_SUCCESS);
+    CHECK(batch_calls == 0);
+
+    /* Every entry runs, in order */
+    CHECK(applet_batch_run(entries, 4, batch_command, &status) == 4);
+    CHECK(status == APPLET_SUCCESS);
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(entries[i].status == APPLET_SUCCESS);
+        CHECK(entries[i].argument[1] == i + 1);
+    }
+
+    /* The batch stops at the first failure and returns its status, the
+     * entries after it are left as the host wrote them */
+    batch_calls = 0;
+    for (i = 0; i < 4; i++)
+    {
+        entries[i].status = APPLET_FAIL;
+        entries[i].argument[1] = 0;
+    }
+    entries[1].argument[0] = APPLET_PROTECT_FAIL;
+    entries[2].argument[0] = APPLET_UNPROTECT_FAIL;
+    CHECK(applet_batch_run(entries, 4, batch_command, &status) == 2);
+    CHECK(status == APPLET_PROTECT_FAIL);
+    CHECK(batch_calls == 2);
+    CHECK(entries[0].status == APPLET_SUCCESS);
+    CHECK(entries[1].status == APPLET_PROTECT_FAIL);
+    CHECK((entries[2].status == APPLET_FAIL) && (entries[2].argument[1] == 0));
+    CHECK((entries[3].status == APPLET_FAIL) && (entries[3].argument[1] == 0));
+}
+
+int main(void)
+{
+    printf("flash applet checks\n");
+
+    test_page_compare();
+    test_row_queue();
+    test_erase_rows();
+    test_nvm_memcpy();
+    test_crc32();
+    test_batch_run();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "passed", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,364 @@
+/**
+ * \file
+ *
+ * \brief cryptoauthlib I2C HAL that drives the ATECC608A model over a timed virtual bus.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <string.h>
+#include <asf.h>
+#include "hal/atca_hal.h"
+#include "atecc608a_sim.h"
+#include "bench_clock.h"
+#include "secure_boot_app.h"
+#include "crypto_device_poll.h"
+#include "hal_i2c_sim.h"
+
+/*
+ * Follows the transaction sequence of hal_samd21_i2c_dma.c so the bus traffic
+ * seen by the model matches the target: wake is a write to address 0 at
+ * 100 kHz, commands are prefixed with the 0x03 word address and the wake and
+ * command responses are polled for by crypto_device_poll.c, other reads get
+ * rx_retries attempts. DMA transfers leave the CPU free, their bus time is
+ * offered to the background digest like a delay.
+ */
+
+#define MAX_I2C_BUSES               6
+#define I2C_WAKE_BAUD               100000
+#define I2C_FAST_MODE_BAUD          400000
+/** SDA/SCL rise time the SERCOM baud calculation allows for (ASF default) */
+#define I2C_RISE_TIME_NS            215
+/** SERCOM disable/re-init cost when switching baud rate */
+#define I2C_CHANGE_SPEED_NS         20000ull
+
+static uint32_t bus_baud[MAX_I2C_BUSES];
+/** Bootloader work done inside HAL delays, see bench_delay_ns() */
+static bool overlap_enabled = true;
+static uint64_t overlap_ns;
+
+static void bench_delay_ns(uint64_t ns);
+
+/** Response read polled by crypto_device_poll_complete() */
+typedef struct
+{
+    int bus;
+    uint8_t slave_address;
+    uint8_t *data;
+    uint16_t length;
+} bus_read;
+
+/** \brief Charges the bus time of one transaction.
+ *  \param[in] baud        Bus speed in Hz
+ *  \param[in] data_bytes  Bytes clocked after the address byte
+ */
+static void bus_transfer(uint32_t baud, size_t data_bytes)
+{
+    /* START, address + ACK, data + ACK, STOP */
+    uint64_t bits = 2 + 9 * (1 + data_bytes);
+
+    bench_clock_advance_ns(bits * 1000000000ull / baud);
+}
+
+/** \brief Charges a DMA transaction, the CPU runs the background digest meanwhile. */
+static void bus_transfer_dma(uint32_t baud, size_t data_bytes)
+{
+    uint64_t bits = 2 + 9 * (1 + data_bytes);
+
+    bench_delay_ns(bits * 1000000000ull / baud);
+}
+
+/** \brief Rate the target HAL ends up with: Fast-mode Plus needs a SERCOM
+ *         clock the ASF baud calculation accepts, otherwise 400 kHz.
+ */
+static uint32_t achievable_baud(uint32_t baud)
+{
+    double fgclk = system_cpu_clock_get_hz();
+
+    if ((baud > I2C_FAST_MODE_BAUD) &&
+        (fgclk - baud * (10 + fgclk * 1e-9 * I2C_RISE_TIME_NS) < 0))
+    {
+        return I2C_FAST_MODE_BAUD;
+    }
+    return baud;
+}
+
+static ATCA_STATUS bus_poll(void *arg)
+{
+    bus_read *read = (bus_read*)arg;
+    bool acked;
+
+    acked = atecc608a_sim_i2c_read(read->slave_address, read->data, read->length);
+    bus_transfer_dma(bus_baud[read->bus], acked ? read->length : 0);
+
+    return acked ? ATCA_SUCCESS : ATCA_COMM_FAIL;
+}
+
+/** \brief Reads a response like hal_i2c_dma_read_response() */
+static ATCA_STATUS bus_read_response(ATCAIfaceCfg *cfg, int bus, uint8_t *data, uint16_t length)
+{
+    int retries = cfg->rx_retries;
+    ATCA_STATUS status = ATCA_COMM_FAIL;
+    bus_read read = { bus, cfg->atcai2c.slave_address, data, length };
+
+    if (crypto_device_poll_pending())
+    {
+        return crypto_device_poll_complete(bus_poll, &read, (2 + 9) * 1000000ul / bus_baud[bus]);
+    }
+
+    while (retries-- > 0 && status != ATCA_SUCCESS)
+    {
+        status = bus_poll(&read);
+    }
+
+    return status;
+}
+
+static void change_i2c_speed(int bus, uint32_t speed)
+{
+    bus_baud[bus] = speed;
+    bench_clock_advance_ns(I2C_CHANGE_SPEED_NS);
+}
+
+ATCA_STATUS hal_i2c_init(void *hal, ATCAIfaceCfg *cfg)
+{
+    if (cfg->atcai2c.bus >= MAX_I2C_BUSES)
+    {
+        return ATCA_COMM_FAIL;
+    }
+    cfg->atcai2c.baud = achievable_baud(cfg->atcai2c.baud);
+    bus_baud[cfg->atcai2c.bus] = cfg->atcai2c.baud;
+    return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_i2c_post_init(ATCAIface iface)
+{
+    return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_i2c_send(ATCAIface iface, uint8_t *txdata, int txlength)
+{
+    ATCAIfaceCfg *cfg = atgetifacecfg(iface);
+    bool acked;
+
+    bench_clock_pause();
+
+    txdata[0] = 0x03;   // insert the Word Address Value, Command token
+    txlength++;         // account for word address value byte.
+
+    crypto_device_poll_cancel();
+    acked = atecc608a_sim_i2c_write(cfg->atcai2c.slave_address, txdata, txlength);
+    bus_transfer_dma(bus_baud[cfg->atcai2c.bus], acked ? txlength : 0);
+    if (acked && txlength >= ATCA_CMD_SIZE_MIN + 1)
+    {
+        crypto_device_poll_start(txdata[2], txdata[1] - ATCA_CMD_SIZE_MIN);
+    }
+
+    bench_clock_resume();
+
+    return acked ? ATCA_SUCCESS : ATCA_COMM_FAIL;
+}
+
+ATCA_STATUS hal_i2c_receive(ATCAIface iface, uint8_t *rxdata, uint16_t *rxlength)
+{
+    ATCAIfaceCfg *cfg = atgetifacecfg(iface);
+    ATCA_STATUS status;
+
+    bench_clock_pause();
+    status = bus_read_response(cfg, cfg->atcai2c.bus, rxdata, *rxlength);
+    bench_clock_resume();
+
+    return status;
+}
+
+ATCA_STATUS hal_i2c_wake(ATCAIface iface)
+{
+    ATCAIfaceCfg *cfg = atgetifacecfg(iface);
+    int bus = cfg->atcai2c.bus;
+    uint32_t bdrt = cfg->atcai2c.baud;
+    bool acked;
+    uint8_t data[4], expected[4] = { 0x04, 0x11, 0x33, 0x43 };
+
+    bench_clock_pause();
+
+    if (bdrt != I2C_WAKE_BAUD)    // if not already at 100KHz, change it
+    {
+        change_i2c_speed(bus, I2C_WAKE_BAUD);
+    }
+
+    /* Address 0x00 holds SDA low for the START and eight address bits */
+    atecc608a_sim_i2c_wake(9 * 1000000000ull / bus_baud[bus]);
+    bus_transfer(bus_baud[bus], 0);
+
+    crypto_device_poll_start(CRYPTO_DEVICE_POLL_WAKE, 0);
+    acked = (bus_read_response(cfg, bus, data, sizeof(data)) == ATCA_SUCCESS);
+
+    if (!acked)
+    {
+        bench_clock_resume();
+        return ATCA_COMM_FAIL;
+    }
+
+    // if necessary, revert baud rate to what came in.
+    if (bdrt != I2C_WAKE_BAUD)
+    {
+        change_i2c_speed(bus, bdrt);
+    }
+
+    bench_clock_resume();
+
+    if (memcmp(data, expected, 4) == 0)
+    {
+        return ATCA_SUCCESS;
+    }
+
+    return ATCA_COMM_FAIL;
+}
+
+static ATCA_STATUS send_word_address(ATCAIface iface, uint8_t word_address)
+{
+    ATCAIfaceCfg *cfg = atgetifacecfg(iface);
+    bool acked;
+
+    bench_clock_pause();
+
+    acked = atecc608a_sim_i2c_write(cfg->atcai2c.slave_address, &word_address, sizeof(word_address));
+    bus_transfer_dma(bus_baud[cfg->atcai2c.bus], acked ? sizeof(word_address) : 0);
+
+    bench_clock_resume();
+
+    return acked ? ATCA_SUCCESS : ATCA_COMM_FAIL;
+}
+
+ATCA_STATUS hal_i2c_idle(ATCAIface iface)
+{
+    crypto_device_poll_cancel();
+    return send_word_address(iface, 0x02);
+}
+
+ATCA_STATUS hal_i2c_sleep(ATCAIface iface)
+{
+    crypto_device_poll_cancel();
+    return send_word_address(iface, 0x01);
+}
+
+ATCA_STATUS hal_i2c_release(void *hal_data)
+{
+    return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_i2c_discover_buses(int i2c_buses[], int max_buses)
+{
+    return ATCA_UNIMPLEMENTED;
+}
+
+ATCA_STATUS hal_i2c_discover_devices(int bus_num, ATCAIfaceCfg cfg[], int *found)
+{
+    return ATCA_UNIMPLEMENTED;
+}
+
+/** \brief Runs the bootloader background digest for the delay, like
+ *         hal_samd21_timer_pipeline.c, and waits out the rest in modelled time.
+ *         HAL code is paused so the digest is charged to the MCU explicitly.
+ */
+static void bench_delay_ns(uint64_t ns)
+{
+    uint64_t start_ns;
+    uint64_t used_ns = 0;
+    int depth;
+
+    if (overlap_enabled)
+    {
+        depth = bench_clock_enter_mcu();
+        start_ns = bench_clock_now_ns();
+        secure_boot_app_background((uint32_t)(ns / 1000));
+        used_ns = bench_clock_now_ns() - start_ns;
+        bench_clock_leave_mcu(depth);
+    }
+
+    if (used_ns < ns)
+    {
+        overlap_ns += used_ns;
+        bench_clock_advance_ns(ns - used_ns);
+    }
+    else
+    {
+        overlap_ns += ns;
+    }
+}
+
+void crypto_device_poll_delay_us(uint32_t delay)
+{
+    bench_delay_ns(delay * 1000ull);
+}
+
+/* The receive waits for the command in flight, as on the target */
+void atca_delay_us(uint32_t delay)
+{
+    if (!crypto_device_poll_pending())
+    {
+        bench_delay_ns(delay * 1000ull);
+    }
+}
+
+void atca_delay_10us(uint32_t delay)
+{
+    atca_delay_us(delay * 10);
+}
+
+void atca_delay_ms(uint32_t delay)
+{
+    atca_delay_us(delay * 1000);
+}
+
+/** \brief Background digest clock, bench time has no wrap or start up cost. */
+void secure_boot_app_clock_start(void)
+{
+}
+
+uint32_t secure_boot_app_clock_us(void)
+{
+    return (uint32_t)(bench_clock_now_ns() / 1000);
+}
+
+void secure_boot_app_clock_stop(void)
+{
+}
+
+/** \brief Turns the background digest off to measure the serial sequence. */
+void hal_i2c_sim_set_overlap(bool enable)
+{
+    overlap_enabled = enable;
+}
+
+void hal_i2c_sim_clear_overlap(void)
+{
+    overlap_ns = 0;
+}
+
+/** \brief Returns the delay time spent hashing since the last clear. */
+uint64_t hal_i2c_sim_overlap_ns(void)
+{
+    return overlap_ns;
+}
@@ -0,0 +1,132 @@
+/**
+ * \file
+ *
+ * \brief Host replacement for the ASF umbrella header used by the secure boot bench.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef ASF_H
+#define ASF_H
+
+/*
+ * Only the subset of ASF referenced by the secure boot memory modules is
+ * provided here. The NVM API keeps the target driver's signatures and argument
+ * checks; it is backed by the RAM flash model in nvm_host.c.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "status_codes.h"
+
+#define NVMCTRL_PAGE_SIZE           64
+#define NVMCTRL_ROW_PAGES           4
+#define NVMCTRL_ROW_SIZE            (NVMCTRL_PAGE_SIZE * NVMCTRL_ROW_PAGES)
+#define NVMCTRL_FLASH_SIZE          (256 * 1024)
+#define FLASH_SIZE                  NVMCTRL_FLASH_SIZE
+#define NVMCTRL_AUX0_ADDRESS        0x00804000
+#define FLASH_PAGE_SIZE             NVMCTRL_PAGE_SIZE
+
+/* Flash is read through its memory mapping, here the RAM flash model */
+uint8_t* nvm_host_flash(uint32_t address);
+#define FLASH_ADDR                  ((uintptr_t)nvm_host_flash(0))
+
+/* As in ASF compiler.h */
+#define COMPILER_WORD_ALIGNED       __attribute__((__aligned__(4)))
+
+/* Core clock of the modelled MCU, OSC8M without prescaler unless the bench
+ * models the verification on the boost clock (bench_clock_set_cpu_hz()) */
+uint32_t bench_clock_cpu_hz(void);
+static inline uint32_t system_cpu_clock_get_hz(void)
+{
+	return bench_clock_cpu_hz();
+}
+
+enum nvm_command {
+	NVM_COMMAND_ERASE_ROW                  = 0x02,
+	NVM_COMMAND_WRITE_PAGE                 = 0x04,
+	NVM_COMMAND_ERASE_AUX_ROW              = 0x05,
+	NVM_COMMAND_WRITE_AUX_ROW              = 0x06,
+	NVM_COMMAND_LOCK_REGION                = 0x40,
+	NVM_COMMAND_UNLOCK_REGION              = 0x41,
+	NVM_COMMAND_PAGE_BUFFER_CLEAR          = 0x44,
+	NVM_COMMAND_SET_SECURITY_BIT           = 0x45,
+};
+
+enum nvm_bootloader_size {
+	NVM_BOOTLOADER_SIZE_128,
+	NVM_BOOTLOADER_SIZE_64,
+	NVM_BOOTLOADER_SIZE_32,
+	NVM_BOOTLOADER_SIZE_16,
+	NVM_BOOTLOADER_SIZE_8,
+	NVM_BOOTLOADER_SIZE_4,
+	NVM_BOOTLOADER_SIZE_2,
+	NVM_BOOTLOADER_SIZE_0,
+};
+
+struct nvm_config {
+	bool manual_page_write;
+	uint8_t wait_states;
+	bool disable_cache;
+};
+
+struct nvm_fusebits {
+	enum nvm_bootloader_size bootloader_size;
+};
+
+static inline void nvm_get_config_defaults(
+		struct nvm_config *const config)
+{
+	config->manual_page_write = true;
+	config->wait_states       = 0;
+	config->disable_cache     = false;
+}
+
+enum status_code nvm_set_config(
+		const struct nvm_config *const config);
+enum status_code nvm_write_buffer(
+		const uint32_t destination_address,
+		const uint8_t *buffer,
+		uint16_t length);
+enum status_code nvm_read_buffer(
+		const uint32_t source_address,
+		uint8_t *const buffer,
+		uint16_t length);
+enum status_code nvm_update_buffer(
+		const uint32_t destination_address,
+		uint8_t *const buffer,
+		uint16_t offset,
+		uint16_t length);
+enum status_code nvm_erase_row(
+		const uint32_t row_address);
+enum status_code nvm_execute_command(
+		const enum nvm_command command,
+		const uint32_t address,
+		const uint32_t parameter);
+enum status_code nvm_get_fuses(struct nvm_fusebits *fusebits);
+enum status_code nvm_set_fuses(struct nvm_fusebits *fb);
+
+#endif /* ASF_H */
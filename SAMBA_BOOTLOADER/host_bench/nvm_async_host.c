@@ -0,0 +1,156 @@
+/**
+ * \file
+ *
+ * \brief NVM job queue of the flash applet, backed by the flash model.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include "nvm_host.h"
+#include "nvm_async_host.h"
+
+/*
+ * Same interface as the applet's nvm_async.c: jobs are queued and only run
+ * from nvm_async_poll() or nvm_async_wait(), so code that reads flash before
+ * the queue is drained sees what the target would see. Each job programs the
+ * flash model through the blocking nvm_* calls and charges their time.
+ */
+
+typedef struct
+{
+	const uint8_t* buffer;
+	nvm_async_callback callback;
+	void* context;
+	uint32_t address;
+	uint16_t length;
+	bool erase;
+} nvm_async_job;
+
+static nvm_async_job nvm_async_queue[NVM_ASYNC_QUEUE_LENGTH];
+static uint8_t nvm_async_head;
+static uint8_t nvm_async_tail;
+static enum status_code nvm_async_status;
+/** Row whose erase fails, as a row the NVM controller reports an error for */
+static uint32_t nvm_async_fail_row = 0xFFFFFFFF;
+
+/** \brief Makes the erase of a row fail until the next nvm_async_init(). */
+void nvm_async_host_fail_row(uint32_t row_address)
+{
+	nvm_async_fail_row = row_address;
+}
+
+void nvm_async_init(void)
+{
+	nvm_async_head = 0;
+	nvm_async_tail = 0;
+	nvm_async_status = STATUS_OK;
+	nvm_async_fail_row = 0xFFFFFFFF;
+}
+
+static enum status_code nvm_async_submit(bool erase, uint32_t address, const uint8_t* buffer,
+		uint16_t length, nvm_async_callback callback, void* context)
+{
+	nvm_async_job* job;
+
+	if (nvm_async_pending() == NVM_ASYNC_QUEUE_LENGTH) {
+		return STATUS_BUSY;
+	}
+
+	job = &nvm_async_queue[nvm_async_tail & (NVM_ASYNC_QUEUE_LENGTH - 1)];
+	job->erase = erase;
+	job->address = address;
+	job->buffer = buffer;
+	job->length = length;
+	job->callback = callback;
+	job->context = context;
+	nvm_async_tail++;
+	return STATUS_OK;
+}
+
+enum status_code nvm_async_erase_row(uint32_t row_address,
+		nvm_async_callback callback, void* context)
+{
+	if ((row_address >= FLASH_SIZE) || (row_address & (NVMCTRL_ROW_SIZE - 1))) {
+		return STATUS_ERR_BAD_ADDRESS;
+	}
+	return nvm_async_submit(true, row_address, NULL, 0, callback, context);
+}
+
+enum status_code nvm_async_write_page(uint32_t page_address, const uint8_t* buffer,
+		uint16_t length, nvm_async_callback callback, void* context)
+{
+	if ((page_address >= FLASH_SIZE) || (page_address & (NVMCTRL_PAGE_SIZE - 1))) {
+		return STATUS_ERR_BAD_ADDRESS;
+	}
+	if ((length == 0) || (length > NVMCTRL_PAGE_SIZE)) {
+		return STATUS_ERR_INVALID_ARG;
+	}
+	return nvm_async_submit(false, page_address, buffer, length, callback, context);
+}
+
+uint8_t nvm_async_pending(void)
+{
+	return (uint8_t)(nvm_async_tail - nvm_async_head);
+}
+
+void nvm_async_poll(void)
+{
+	nvm_async_job* job;
+	enum status_code status;
+
+	if (nvm_async_pending() == 0) {
+		return;
+	}
+
+	job = &nvm_async_queue[nvm_async_head & (NVM_ASYNC_QUEUE_LENGTH - 1)];
+	if (job->erase) {
+		status = (job->address == nvm_async_fail_row) ? STATUS_ERR_IO : nvm_erase_row(job->address);
+	} else {
+		status = nvm_write_buffer(job->address, job->buffer, job->length);
+	}
+	/* The target reports any controller error as an aborted job */
+	if (status != STATUS_OK) {
+		status = STATUS_ABORTED;
+		if (nvm_async_status == STATUS_OK) {
+			nvm_async_status = STATUS_ABORTED;
+		}
+	}
+	nvm_async_head++;
+
+	if (job->callback) {
+		job->callback(status, job->context);
+	}
+}
+
+enum status_code nvm_async_wait(void)
+{
+	enum status_code status;
+
+	while (nvm_async_pending()) {
+		nvm_async_poll();
+	}
+	status = nvm_async_status;
+	nvm_async_status = STATUS_OK;
+	return status;
+}
@@ -0,0 +1,237 @@
+/**
+ * \file
+ *
+ * \brief RAM backed SAMD21 flash model for the secure boot bench.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include "nvm_host.h"
+#include "bench_clock.h"
+
+/* Flash is kept as 16-bit words, like NVM_MEMORY on the target */
+static uint16_t flash_memory[NVMCTRL_FLASH_SIZE / 2];
+static struct nvm_fusebits fuse_bits = { .bootloader_size = NVM_BOOTLOADER_SIZE_0 };
+static nvm_host_stats stats;
+
+/** \brief Erases the whole flash and clears fuses and counters. */
+void nvm_host_reset(void)
+{
+	memset(flash_memory, 0xFF, sizeof(flash_memory));
+	fuse_bits.bootloader_size = NVM_BOOTLOADER_SIZE_0;
+	nvm_host_clear_stats();
+}
+
+/** \brief Copies an image into flash without charging programming time. */
+bool nvm_host_load(uint32_t address, const uint8_t* data, size_t length)
+{
+	if ((address > NVMCTRL_FLASH_SIZE) || (length > (NVMCTRL_FLASH_SIZE - address)))
+	{
+		return false;
+	}
+	memcpy((uint8_t*)flash_memory + address, data, length);
+	return true;
+}
+
+/** \brief Returns a direct pointer into the flash model. */
+uint8_t* nvm_host_flash(uint32_t address)
+{
+	return (uint8_t*)flash_memory + address;
+}
+
+const nvm_host_stats* nvm_host_get_stats(void)
+{
+	return &stats;
+}
+
+void nvm_host_clear_stats(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+enum status_code nvm_set_config(
+		const struct nvm_config *const config)
+{
+	(void)config;
+	return STATUS_OK;
+}
+
+enum status_code nvm_write_buffer(
+		const uint32_t destination_address,
+		const uint8_t *buffer,
+		uint16_t length)
+{
+	uint8_t *page;
+
+	if (destination_address >= NVMCTRL_FLASH_SIZE) {
+		return STATUS_ERR_BAD_ADDRESS;
+	}
+	if (destination_address & (NVMCTRL_PAGE_SIZE - 1)) {
+		return STATUS_ERR_BAD_ADDRESS;
+	}
+	if (length > NVMCTRL_PAGE_SIZE) {
+		return STATUS_ERR_INVALID_ARG;
+	}
+
+	/* Programming can only clear bits; the rest of the page buffer is 0xFF */
+	page = (uint8_t*)flash_memory + destination_address;
+	for (uint16_t i = 0; i < length; i++) {
+		page[i] &= buffer[i];
+	}
+
+	stats.page_writes++;
+	bench_clock_advance_ns(NVM_HOST_PAGE_WRITE_NS);
+
+	return STATUS_OK;
+}
+
+enum status_code nvm_read_buffer(
+		const uint32_t source_address,
+		uint8_t *const buffer,
+		uint16_t length)
+{
+	if (source_address >= NVMCTRL_FLASH_SIZE) {
+		return STATUS_ERR_BAD_ADDRESS;
+	}
+	if (source_address & (NVMCTRL_PAGE_SIZE - 1)) {
+		return STATUS_ERR_BAD_ADDRESS;
+	}
+	if (length > NVMCTRL_PAGE_SIZE) {
+		return STATUS_ERR_INVALID_ARG;
+	}
+
+	uint32_t page_address = source_address / 2;
+
+	/* Same 16-bit copy loop as the target driver */
+	for (uint16_t i = 0; i < length; i += 2) {
+		uint16_t data = flash_memory[page_address++];
+
+		buffer[i] = (data & 0xFF);
+		if (i < (length - 1)) {
+			buffer[i + 1] = (data >> 8);
+		}
+	}
+
+	return STATUS_OK;
+}
+
+enum status_code nvm_update_buffer(
+		const uint32_t destination_address,
+		uint8_t *const buffer,
+		uint16_t offset,
+		uint16_t length)
+{
+	enum status_code error_code;
+	uint8_t row_buffer[NVMCTRL_ROW_PAGES][NVMCTRL_PAGE_SIZE];
+
+	if ((offset + length) > NVMCTRL_PAGE_SIZE) {
+		return STATUS_ERR_INVALID_ARG;
+	}
+
+	uint32_t row_start_address = destination_address & ~(NVMCTRL_ROW_SIZE - 1);
+
+	for (uint32_t i = 0; i < NVMCTRL_ROW_PAGES; i++) {
+		error_code = nvm_read_buffer(row_start_address + (i * NVMCTRL_PAGE_SIZE),
+				row_buffer[i], NVMCTRL_PAGE_SIZE);
+		if (error_code != STATUS_OK) {
+			return error_code;
+		}
+	}
+
+	uint8_t page_in_row = (destination_address % NVMCTRL_ROW_SIZE) / NVMCTRL_PAGE_SIZE;
+	memcpy(&row_buffer[page_in_row][offset], buffer, length);
+
+	error_code = nvm_erase_row(row_start_address);
+	if (error_code != STATUS_OK) {
+		return error_code;
+	}
+
+	for (uint32_t i = 0; i < NVMCTRL_ROW_PAGES; i++) {
+		error_code = nvm_write_buffer(row_start_address + (i * NVMCTRL_PAGE_SIZE),
+				row_buffer[i], NVMCTRL_PAGE_SIZE);
+		if (error_code != STATUS_OK) {
+			return error_code;
+		}
+	}
+
+	return STATUS_OK;
+}
+
+enum status_code nvm_erase_row(
+		const uint32_t row_address)
+{
+	if (row_address >= NVMCTRL_FLASH_SIZE) {
+		return STATUS_ERR_BAD_ADDRESS;
+	}
+	if (row_address & (NVMCTRL_ROW_SIZE - 1)) {
+		return STATUS_ERR_BAD_ADDRESS;
+	}
+
+	memset((uint8_t*)flash_memory + row_address, 0xFF, NVMCTRL_ROW_SIZE);
+
+	stats.row_erases++;
+	bench_clock_advance_ns(NVM_HOST_ROW_ERASE_NS);
+
+	return STATUS_OK;
+}
+
+enum status_code nvm_execute_command(
+		const enum nvm_command command,
+		const uint32_t address,
+		const uint32_t parameter)
+{
+	(void)parameter;
+
+	switch (command) {
+		case NVM_COMMAND_ERASE_ROW:
+			return nvm_erase_row(address);
+
+		case NVM_COMMAND_SET_SECURITY_BIT:
+			stats.security_bit = true;
+			return STATUS_OK;
+
+		case NVM_COMMAND_LOCK_REGION:
+		case NVM_COMMAND_UNLOCK_REGION:
+		case NVM_COMMAND_PAGE_BUFFER_CLEAR:
+			return STATUS_OK;
+
+		default:
+			return STATUS_ERR_INVALID_ARG;
+	}
+}
+
+enum status_code nvm_get_fuses(struct nvm_fusebits *fusebits)
+{
+	*fusebits = fuse_bits;
+	return STATUS_OK;
+}
+
+enum status_code nvm_set_fuses(struct nvm_fusebits *fb)
+{
+	fuse_bits = *fb;
+	stats.fuse_writes++;
+	/* User row erase plus write */
+	bench_clock_advance_ns(NVM_HOST_ROW_ERASE_NS + NVM_HOST_PAGE_WRITE_NS);
+	return STATUS_OK;
+}
@@ -0,0 +1,62 @@
+/**
+ * \file
+ *
+ * \brief RAM backed SAMD21 flash model for the secure boot bench.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef NVM_HOST_H
+#define NVM_HOST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <asf.h>
+
+/** Modelled NVM controller timings (SAMD21 datasheet maximums) */
+#define NVM_HOST_PAGE_WRITE_NS      2500000ull
+#define NVM_HOST_ROW_ERASE_NS       6000000ull
+
+/** \brief Counters of NVM operations issued since the last reset */
+typedef struct
+{
+	uint32_t page_writes;
+	uint32_t row_erases;
+	uint32_t fuse_writes;
+	bool security_bit;
+} nvm_host_stats;
+
+void nvm_host_reset(void);
+bool nvm_host_load(uint32_t address, const uint8_t* data, size_t length);
+uint8_t* nvm_host_flash(uint32_t address);
+const nvm_host_stats* nvm_host_get_stats(void);
+void nvm_host_clear_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
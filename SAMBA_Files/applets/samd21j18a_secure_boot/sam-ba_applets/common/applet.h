@@ -77,6 +77,14 @@
 #define APPLET_CMD_READ_FUSES        0x43
 /** Applet erase application section command */
 #define APPLET_CMD_ERASE_APP         0x44
+/** Applet write and verify command */
+#define APPLET_CMD_WRITE_VERIFY      0x46
+/** Applet flash CRC32 compare command */
+#define APPLET_CMD_CRC32             0x47
+/** Applet flash SHA-256 digest command */
+#define APPLET_CMD_SHA256            0x48
+/** Applet batched commands command */
+#define APPLET_CMD_BATCH             0x49
 
 
 /** Operation was successful.*/
@@ -74,6 +74,9 @@
 
 #include <string.h>
 #include <nvm.h>
+#include "nvm_async.h"
+#include "flash_app_ops.h"
+#include "crypto/hashes/sha2_routines.h"
 #include "status_codes.h"
 #include <system.h>
 #include <system_interrupt.h>
@@ -86,6 +89,16 @@
 #define STACK_SIZE (0x500)
 //Typical monitor size when compiled (rounded to 8kb upper bound)
 #define MONITOR_SIZE (0x8000)
+//Argument words of the 32 word mailbox
+#define APPLET_ARGUMENT_WORDS (32 - 2)
+//Mismatch offset reported when flash holds the data
+#define APPLET_NO_MISMATCH (0xFFFFFFFF)
+//Features reported by INIT, the host only uses what the applet it loaded has
+#define APPLET_FEATURE_ERASE_COUNT (1 << 0)
+#define APPLET_FEATURE_WRITE_VERIFY (1 << 1)
+#define APPLET_FEATURE_CRC32 (1 << 2)
+#define APPLET_FEATURE_SHA256 (1 << 3)
+#define APPLET_FEATURE_BATCH (1 << 4)
 
 // Empty macro
 #define TRACE_DEBUG(...)      { }
@@ -143,6 +156,8 @@ struct _Mailbox {
             uint32_t pageSize;
             uint32_t nbPages;
             uint32_t appStartPage;
+            /** APPLET_FEATURE_ bits, 0 for an applet without them.*/
+            uint32_t features;
         } outputInit;
 
         /** Input arguments for the Write command.*/
@@ -270,7 +285,67 @@ struct _Mailbox {
         } inputEraseApp;
 
         /** Output arguments for the erase app command */
-        /** NONE */
+        struct {
+            /** Rows that were not blank and have been erased */
+            uint32_t rowsErased;
+        } outputEraseApp;
+
+        /** Input arguments for the Write and Verify command, as Write */
+
+        /** Output arguments for the Write and Verify command.*/
+        struct {
+            /** Bytes written.*/
+            uint32_t bytesWritten;
+            /** Memory offset of the first byte flash does not hold,
+             *  APPLET_NO_MISMATCH if none.*/
+            uint32_t mismatchOffset;
+        } outputWriteVerify;
+
+        /** Input arguments for the CRC32 command.*/
+        struct {
+            /** Memory offset, word aligned.*/
+            uint32_t memoryOffset;
+            /** Bytes to check.*/
+            uint32_t size;
+            /** CRC32 (IEEE 802.3, as zlib) of the data expected in flash.*/
+            uint32_t crc;
+        } inputCrc32;
+
+        /** Output arguments for the CRC32 command.*/
+        struct {
+            /** CRC32 of the flash contents.*/
+            uint32_t crc;
+        } outputCrc32;
+
+        /** Input arguments for the SHA-256 command.*/
+        struct {
+            /** Buffer address, receives the 32 byte digest.*/
+            uint32_t bufferAddr;
+            /** Bytes to hash.*/
+            uint32_t size;
+            /** Memory offset.*/
+            uint32_t memoryOffset;
+        } inputSha256;
+
+        /** Output arguments for the SHA-256 command */
+        /** NONE, the digest is in the buffer */
+
+        /** Input arguments for the Batch command.*/
+        struct {
+            /** Buffer address of the _BatchEntry list.*/
+            uint32_t bufferAddr;
+            /** Number of entries.*/
+            uint32_t count;
+        } inputBatch;
+
+        /** Output arguments for the Batch command.*/
+        struct {
+            /** Entries run, the last one run failed if it is less than count.*/
+            uint32_t commandsRun;
+        } outputBatch;
+
+        /** Fixes the size of the argument area */
+        uint32_t words[APPLET_ARGUMENT_WORDS];
     } argument;
 };
 
@@ -296,82 +371,49 @@ bool applet_nvm_islocked(uint32_t addstart,uint32_t addend)
 	return (false);
 }
 
-enum status_code applet_nvm_memcpy(
-		const uint32_t destination_address,
-		uint8_t *const buffer,
-		uint16_t length,
-		bool erase_flag)
+/**
+ * \brief Compares flash with the data it was programmed from.
+ *
+ * \return Offset of the first byte that differs, APPLET_NO_MISMATCH if none.
+ */
+static uint32_t applet_verify(uint32_t address, const uint8_t *data, uint32_t length)
 {
-	enum status_code error_code = STATUS_OK;
-	uint8_t row_buffer[NVMCTRL_ROW_PAGES * FLASH_PAGE_SIZE];
-	volatile uint8_t *dest_add = (uint8_t *)destination_address;
-	const uint8_t *src_buf = buffer;
+	const uint8_t *flash = (const uint8_t *)address;
 	uint32_t i;
 
-	/* Calculate the starting row address of the page to update */
-	uint32_t row_start_address =
-			destination_address & ~((FLASH_PAGE_SIZE * NVMCTRL_ROW_PAGES) - 1);
-
-	while (length) {
-		/* Backup the contents of a row */
-		for (i = 0; i < NVMCTRL_ROW_PAGES; i++) {
-			do
-			{
-				error_code = nvm_read_buffer(
-				row_start_address + (i * FLASH_PAGE_SIZE),
-				(row_buffer + (i * FLASH_PAGE_SIZE)), FLASH_PAGE_SIZE);
-			} while (error_code == STATUS_BUSY);
-
-			if (error_code != STATUS_OK) {
-				return error_code;
-			}
-		}
-		
-		/* Update the buffer if necessary */
-		for (i = row_start_address; i < row_start_address + (FLASH_PAGE_SIZE * NVMCTRL_ROW_PAGES); i++)
-		{
-			if (length && ((uint8_t *)i == dest_add)) {
-				row_buffer[i-row_start_address] = *src_buf++;
-				dest_add++;
-				length--;
-			}
-		}
-		
-		system_interrupt_enter_critical_section();
-
-		if (erase_flag) {
-			/* Erase the row */
-			do
-			{
-				error_code = nvm_erase_row(row_start_address);
-			} while (error_code == STATUS_BUSY);
-
-			if (error_code != STATUS_OK) {
-				return error_code;
-			}
-		}
-
-		/* Write the updated row contents to the erased row */
-		for (i = 0; i < NVMCTRL_ROW_PAGES; i++) {
-			do
-			{
-				error_code = nvm_write_buffer(
-				row_start_address + (i * FLASH_PAGE_SIZE),
-				(row_buffer + (i * FLASH_PAGE_SIZE)), FLASH_PAGE_SIZE);
-			} while (error_code == STATUS_BUSY);
-
-			if (error_code != STATUS_OK) {
-				return error_code;
-			}
+	for (i = 0; i < length; i++) {
+		if (flash[i] != data[i]) {
+			return i;
 		}
-
-		system_interrupt_leave_critical_section();
-
-		row_start_address += NVMCTRL_ROW_PAGES * NVMCTRL_PAGE_SIZE;
-
 	}
+	return APPLET_NO_MISMATCH;
+}
 
-	return error_code;
+/**
+ * \brief Runs the DSU CRC32 over whole words of flash, for applet_crc32().
+ *
+ * \return false if the DSU refuses the area, as it does on a protected
+ *         device.
+ */
+bool applet_crc32_dsu(uint32_t address, uint32_t length, uint32_t *crc)
+{
+	bool done;
+
+	/* The DSU is write protected by PAC1 out of reset */
+	PAC1->WPCLR.reg = 1u << (ID_DSU - 32);
+	DSU->STATUSA.reg = DSU_STATUSA_DONE | DSU_STATUSA_BERR;
+	DSU->ADDR.reg = FLASH_ADDR + address;
+	DSU->LENGTH.reg = length;
+	DSU->DATA.reg = *crc;
+	DSU->CTRL.reg = DSU_CTRL_CRC;
+	while (!(DSU->STATUSA.reg & DSU_STATUSA_DONE)) {
+	}
+	done = !(DSU->STATUSA.reg & DSU_STATUSA_BERR);
+	if (done) {
+		*crc = DSU->DATA.reg;
+	}
+	PAC1->WPSET.reg = 1u << (ID_DSU - 32);
+	return done;
 }
 
 
@@ -402,8 +444,29 @@ static volatile  uint32_t flashLockRegionSize;
 static volatile  uint32_t lastWrittenAddr = 0;
 /** Flash pages in a row */
 static volatile uint32_t flashNbPagesOneRow;
-/** Current row number */
-static volatile uint16_t row;
+/** SHA-256 context, kept off the applet stack */
+static sw_sha256_ctx applet_sha256;
+/** Mailbox a batched command runs in */
+static struct _Mailbox applet_batch_mailbox;
+
+static void applet_command(struct _Mailbox *pMailbox);
+
+/**
+ * \brief Runs one entry of APPLET_CMD_BATCH in applet_batch_mailbox. INIT
+ *        and nested batches are not batched and fail.
+ */
+static void applet_batch_command(struct _BatchEntry *entry)
+{
+	memset(&applet_batch_mailbox, 0, sizeof(applet_batch_mailbox));
+	applet_batch_mailbox.command = entry->command;
+	applet_batch_mailbox.status = APPLET_FAIL;
+	memcpy(applet_batch_mailbox.argument.words, entry->argument, sizeof(entry->argument));
+	if ((entry->command != APPLET_CMD_INIT) && (entry->command != APPLET_CMD_BATCH)) {
+		applet_command(&applet_batch_mailbox);
+	}
+	memcpy(entry->argument, applet_batch_mailbox.argument.words, sizeof(entry->argument));
+	entry->status = applet_batch_mailbox.status;
+}
 
 /*----------------------------------------------------------------------------
  *        Global functions
@@ -418,15 +481,15 @@ int applet_main(int argc, char **argv)
 {
 	struct _Mailbox *pMailbox = (struct _Mailbox *) argv;
 	struct nvm_config config;
-	enum status_code status;
-
-	uint32_t bytesToWrite, bufferAddr, memoryOffset;
 
 	// Save info of communication link
 	comType = pMailbox->argument.inputInit.comType;
 
 	nvm_get_config_defaults(&config);
 	nvm_set_config(&config);
+	/* Erase and write jobs are polled, the applet runs with interrupts
+	 * disabled under the monitor's vector table */
+	nvm_async_init();
 
 	//Applet vars are cleared on every load
 	flashBaseAddr       = FLASH_ADDR;
@@ -437,6 +500,30 @@ int applet_main(int argc, char **argv)
 	flashLockRegionSize = flashSize/flashNbLockBits;
 	flashNbPagesOneRow  = 4; //Hardcoded
 
+	applet_command(pMailbox);
+
+	/* Acknowledge the end of command */
+	TRACE_INFO("\tEnd of Applet %x %x.\n\r",
+				(uint32_t)pMailbox->command,
+				(uint32_t)pMailbox->status);
+	/* Notify the host application of the end of the command processing */
+	pMailbox->command = ~(pMailbox->command);
+
+	SERCOM3->USART.DATA.reg = 0x6;
+	return 0;
+}
+
+/**
+ * \brief  Decodes a command and executes it, for applet_main() and for each
+ *         entry of APPLET_CMD_BATCH.
+ */
+static void applet_command(struct _Mailbox *pMailbox)
+{
+	struct _BatchEntry *entry;
+	enum status_code status;
+
+	uint32_t bytesToWrite, bufferAddr, memoryOffset, i;
+
 	/*----------------------------------------------------------
 	 * INIT:
 	 *----------------------------------------------------------*/
@@ -464,6 +551,10 @@ int applet_main(int argc, char **argv)
 		pMailbox->argument.outputInit.nbPages = flashSize/flashPageSize;
 		pMailbox->argument.outputInit.appStartPage = MONITOR_SIZE/flashPageSize;
 
+		pMailbox->argument.outputInit.features = APPLET_FEATURE_ERASE_COUNT
+				| APPLET_FEATURE_WRITE_VERIFY | APPLET_FEATURE_CRC32
+				| APPLET_FEATURE_SHA256 | APPLET_FEATURE_BATCH;
+
 		TRACE_INFO("bufferSize : %d  bufferAddr: 0x%x \n\r",
 				(int)pMailbox->argument.outputInit.bufferSize,
 				(uint32_t) &end );
@@ -506,7 +597,7 @@ int applet_main(int argc, char **argv)
 		
 		TRACE_INFO("Write <%x> bytes from <#%x> \n\r", (uint32_t )writeSize, (uint32_t )memoryOffset );
 		
-		if (applet_nvm_memcpy(flashBaseAddr + memoryOffset, (uint8_t *const)bufferAddr, bytesToWrite, (((flashBaseAddr + memoryOffset) & 0xFF) == 0)) != STATUS_OK) {
+		if (applet_nvm_memcpy(flashBaseAddr + memoryOffset, (uint8_t *const)bufferAddr, bytesToWrite) != STATUS_OK) {
 			TRACE_INFO("Error in write operation\n\r");
 			pMailbox->argument.outputWrite.bytesWritten = bytesToWrite;
 			pMailbox->status = APPLET_WRITE_FAIL;
@@ -519,6 +610,93 @@ int applet_main(int argc, char **argv)
 	
 	}
 
+	/*----------------------------------------------------------
+	 * WRITE AND VERIFY:
+	 *----------------------------------------------------------*/
+	else if (pMailbox->command == APPLET_CMD_WRITE_VERIFY) {
+
+		memoryOffset  = pMailbox->argument.inputWrite.memoryOffset;
+		bufferAddr    = pMailbox->argument.inputWrite.bufferAddr;
+		bytesToWrite  = pMailbox->argument.inputWrite.bufferSize;
+
+		pMailbox->argument.outputWriteVerify.bytesWritten = 0;
+		pMailbox->argument.outputWriteVerify.mismatchOffset = APPLET_NO_MISMATCH;
+		//Protect monitor address space from write
+		if ((flashBaseAddr + memoryOffset) < MONITOR_SIZE) {
+			TRACE_INFO("Error write operation\n\r");
+			pMailbox->status = APPLET_WRITE_FAIL;
+			goto exit;
+		}
+		/* Check if one of the given regions is locked */
+		if (applet_nvm_islocked(flashBaseAddr + memoryOffset, (flashBaseAddr + memoryOffset + bytesToWrite)-1) != 0) {
+			TRACE_INFO("Error page locked\n\r");
+			pMailbox->status = APPLET_WRITE_FAIL;
+			goto exit;
+		}
+
+		if (applet_nvm_memcpy(flashBaseAddr + memoryOffset, (uint8_t *const)bufferAddr, bytesToWrite) != STATUS_OK) {
+			TRACE_INFO("Error in write operation\n\r");
+			pMailbox->status = APPLET_WRITE_FAIL;
+		} else {
+			pMailbox->status = APPLET_SUCCESS;
+		}
+		pMailbox->argument.outputWriteVerify.bytesWritten = bytesToWrite;
+
+		/* Read back on the target instead of by the host */
+		i = applet_verify(flashBaseAddr + memoryOffset, (const uint8_t *)bufferAddr, bytesToWrite);
+		if (i != APPLET_NO_MISMATCH) {
+			TRACE_INFO("Verify failed at 0x%x\n\r", (uint32_t)(memoryOffset + i));
+			pMailbox->argument.outputWriteVerify.mismatchOffset = memoryOffset + i;
+			pMailbox->status = APPLET_WRITE_FAIL;
+		}
+	}
+
+	/*----------------------------------------------------------
+	 * CRC32:
+	 *----------------------------------------------------------*/
+	else if (pMailbox->command == APPLET_CMD_CRC32) {
+
+		memoryOffset  = pMailbox->argument.inputCrc32.memoryOffset;
+		bytesToWrite  = pMailbox->argument.inputCrc32.size;
+		i             = pMailbox->argument.inputCrc32.crc;
+
+		/* The DSU works on whole words */
+		if (((flashBaseAddr + memoryOffset) & 3)
+				|| (memoryOffset > flashSize) || (bytesToWrite > (flashSize - memoryOffset))) {
+			TRACE_INFO("Error CRC32 area\n\r");
+			pMailbox->status = APPLET_ALIGN_ERROR;
+			goto exit;
+		}
+
+		pMailbox->argument.outputCrc32.crc = applet_crc32(memoryOffset, bytesToWrite);
+		pMailbox->status = (pMailbox->argument.outputCrc32.crc == i) ?
+				APPLET_SUCCESS : APPLET_READ_FAIL;
+	}
+
+	/*----------------------------------------------------------
+	 * SHA-256:
+	 *----------------------------------------------------------*/
+	else if (pMailbox->command == APPLET_CMD_SHA256) {
+
+		memoryOffset  = pMailbox->argument.inputSha256.memoryOffset;
+		bufferAddr    = pMailbox->argument.inputSha256.bufferAddr;
+		bytesToWrite  = pMailbox->argument.inputSha256.size;
+
+		if ((memoryOffset > flashSize) || (bytesToWrite > (flashSize - memoryOffset))) {
+			TRACE_INFO("Error SHA-256 area\n\r");
+			pMailbox->status = APPLET_FAIL;
+			goto exit;
+		}
+
+		/* Hashed straight from flash, the host signs what the part holds
+		 * without reading the image back */
+		sw_sha256_init(&applet_sha256);
+		sw_sha256_update(&applet_sha256, (const uint8_t *)(flashBaseAddr + memoryOffset), bytesToWrite);
+		sw_sha256_final(&applet_sha256, (uint8_t *)bufferAddr);
+		TRACE_INFO("SHA-256 achieved\n\r");
+		pMailbox->status = APPLET_SUCCESS;
+	}
+
 	/*----------------------------------------------------------
 	 * READ:
 	 *----------------------------------------------------------*/
@@ -588,15 +766,20 @@ int applet_main(int argc, char **argv)
 	 * ERASE APP SECTION :
 	 *-----------------------------------------------------------*/
 	else if (pMailbox->command == APPLET_CMD_ERASE_APP) {
-		row = pMailbox->argument.inputEraseApp.start_row;
+		uint32_t start_row = pMailbox->argument.inputEraseApp.start_row;
+		uint32_t end_row = pMailbox->argument.inputEraseApp.end_row;
+		uint32_t rows_erased;
+
 		TRACE_INFO("ERASE APP command \n\r");
 
-		do {
-			/* Erase the flash row */
-			while (nvm_erase_row(row * 4 * FLASH_PAGE_SIZE) != STATUS_OK);
-			row++;
-		} while(row < pMailbox->argument.inputEraseApp.end_row);
+		status = applet_erase_rows(start_row, end_row, &rows_erased);
+		pMailbox->argument.outputEraseApp.rowsErased = rows_erased;
 
+		if (status != STATUS_OK) {
+			TRACE_INFO("Application area erase failed! \n\r");
+			pMailbox->status = APPLET_ERASE_FAIL;
+			goto exit;
+		}
 		TRACE_INFO("Application area erased\n\r");
 		pMailbox->status = APPLET_SUCCESS;
 	}
@@ -675,16 +858,21 @@ int applet_main(int argc, char **argv)
 		pMailbox->status = APPLET_SUCCESS;
 	}
 
+	/*----------------------------------------------------------
+	 * BATCH:
+	 *----------------------------------------------------------*/
+	else if (pMailbox->command == APPLET_CMD_BATCH) {
+		entry = (struct _BatchEntry *) pMailbox->argument.inputBatch.bufferAddr;
+		bytesToWrite = pMailbox->argument.inputBatch.count;
+
+		/* The entries run back to back in one applet call */
+		i = applet_batch_run(entry, bytesToWrite, applet_batch_command,
+				&pMailbox->status);
+		TRACE_INFO("Batch of %d commands run\n\r", (uint32_t)i);
+		pMailbox->argument.outputBatch.commandsRun = i;
+	}
 
 exit:
-	/* Acknowledge the end of command */
-	TRACE_INFO("\tEnd of Applet %x %x.\n\r",
-				(uint32_t)pMailbox->command,
-				(uint32_t)pMailbox->status);
-	/* Notify the host application of the end of the command processing */
-	pMailbox->command = ~(pMailbox->command);
-
-	SERCOM3->USART.DATA.reg = 0x6;
-	return 0;
+	return;
 }
 
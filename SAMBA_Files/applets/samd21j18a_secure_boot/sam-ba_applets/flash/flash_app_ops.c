@@ -0,0 +1,278 @@
+/**
+ * \file
+ *
+ * \brief Flash checks and row planning of the flash applet, free of peripheral
+ *        access so the host bench can run them against its flash model.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <string.h>
+#include <nvm.h>
+#include "../common/applet.h"
+#include "flash_app_ops.h"
+
+/*
+ * Flash is read through its memory mapping at FLASH_ADDR, and programmed
+ * through the nvm_async job queue. Nothing here touches a peripheral, the
+ * host bench links this file with its own flash model and job queue.
+ */
+
+/**
+ * \brief Compares a page of new data with the flash it goes to, a word at
+ *        a time
+ */
+uint8_t applet_page_compare(const uint32_t *flash, const uint32_t *data)
+{
+	uint8_t result = APPLET_PAGE_SAME;
+	uint32_t i;
+
+	for (i = 0; i < FLASH_PAGE_SIZE / sizeof(uint32_t); i++) {
+		if (flash[i] != data[i]) {
+			if ((flash[i] & data[i]) != data[i]) {
+				return APPLET_PAGE_ERASE;
+			}
+			result = APPLET_PAGE_PROGRAM;
+		}
+	}
+	return result;
+}
+
+/**
+ * \brief Compares a merged row with flash and queues the jobs it needs:
+ *        unchanged pages are skipped, and the row is only erased when the
+ *        data sets bits that are programmed to 0. jobs counts the jobs
+ *        queued with callback. The controller must be idle.
+ */
+enum status_code applet_row_queue(uint32_t row_start_address,
+		const uint8_t *row_buffer, nvm_async_callback callback, uint8_t *jobs)
+{
+	enum status_code error_code = STATUS_OK;
+	uint8_t pages[NVMCTRL_ROW_PAGES];
+	uint32_t erased[FLASH_PAGE_SIZE / sizeof(uint32_t)];
+	bool erase = false;
+	uint32_t i;
+
+	for (i = 0; i < NVMCTRL_ROW_PAGES; i++) {
+		pages[i] = applet_page_compare(
+				(const uint32_t *)(FLASH_ADDR + row_start_address + (i * FLASH_PAGE_SIZE)),
+				(const uint32_t *)(row_buffer + (i * FLASH_PAGE_SIZE)));
+		if (pages[i] == APPLET_PAGE_ERASE) {
+			erase = true;
+		}
+	}
+
+	if (erase) {
+		(*jobs)++;
+		error_code = nvm_async_erase_row(row_start_address, callback, NULL);
+		if (error_code != STATUS_OK) {
+			(*jobs)--;
+			return error_code;
+		}
+		/* Once erased, only the pages holding data are programmed */
+		memset(erased, 0xFF, sizeof(erased));
+		for (i = 0; i < NVMCTRL_ROW_PAGES; i++) {
+			pages[i] = applet_page_compare(erased,
+					(const uint32_t *)(row_buffer + (i * FLASH_PAGE_SIZE)));
+		}
+	}
+
+	for (i = 0; i < NVMCTRL_ROW_PAGES; i++) {
+		if (pages[i] == APPLET_PAGE_SAME) {
+			continue;
+		}
+		(*jobs)++;
+		error_code = nvm_async_write_page(
+				row_start_address + (i * FLASH_PAGE_SIZE),
+				(row_buffer + (i * FLASH_PAGE_SIZE)), FLASH_PAGE_SIZE, callback, NULL);
+		if (error_code != STATUS_OK) {
+			(*jobs)--;
+			return error_code;
+		}
+	}
+	return STATUS_OK;
+}
+
+/** Rows being merged and programmed, one is filled while the other one is
+ *  programmed from the NVMCTRL job queue */
+static uint8_t applet_row_buffer[2][NVMCTRL_ROW_PAGES * FLASH_PAGE_SIZE] COMPILER_WORD_ALIGNED;
+
+/**
+ * \brief Merges data into a row buffer. The contents of a row the data does
+ *        not cover are read back first, the read waits for the row in flight.
+ */
+static void applet_row_merge(uint8_t *row_buffer, uint32_t row_start_address,
+		uint32_t offset, const uint8_t *src_buf, uint32_t chunk)
+{
+	if (chunk < (NVMCTRL_ROW_PAGES * FLASH_PAGE_SIZE)) {
+		memcpy(row_buffer, (const void *)(FLASH_ADDR + row_start_address), NVMCTRL_ROW_PAGES * FLASH_PAGE_SIZE);
+	}
+	memcpy(row_buffer + offset, src_buf, chunk);
+}
+
+/**
+ * \brief Programs a buffer into flash row by row, see applet_row_queue().
+ *        The next row is merged in SRAM while the previous one is still
+ *        being programmed. Returns once every row is programmed.
+ */
+enum status_code applet_nvm_memcpy(
+		const uint32_t destination_address,
+		uint8_t *const buffer,
+		uint16_t length)
+{
+	enum status_code error_code = STATUS_OK;
+	const uint32_t row_size = NVMCTRL_ROW_PAGES * FLASH_PAGE_SIZE;
+	const uint8_t *src_buf = buffer;
+	uint8_t *row_buffer;
+	uint8_t current = 0;
+	uint8_t jobs = 0;
+	uint32_t offset, chunk;
+
+	/* Calculate the starting row address of the page to update */
+	uint32_t row_start_address = destination_address & ~(row_size - 1);
+
+	offset = destination_address - row_start_address;
+	while (length) {
+		row_buffer = applet_row_buffer[current];
+		chunk = row_size - offset;
+		if (chunk > length) {
+			chunk = length;
+		}
+		applet_row_merge(row_buffer, row_start_address, offset, src_buf, chunk);
+
+		/* The previous row has to be done before this one is compared and
+		 * queued */
+		error_code = nvm_async_wait();
+		if (error_code != STATUS_OK) {
+			return error_code;
+		}
+
+		error_code = applet_row_queue(row_start_address, row_buffer, NULL, &jobs);
+		if (error_code != STATUS_OK) {
+			nvm_async_wait();
+			return error_code;
+		}
+
+		src_buf += chunk;
+		length -= chunk;
+		offset = 0;
+		current ^= 1;
+		row_start_address += row_size;
+	}
+
+	return nvm_async_wait();
+}
+
+/**
+ * \brief Checks whether a row is erased, a word at a time
+ */
+bool applet_row_is_blank(uint32_t row_address)
+{
+	const uint32_t *words = (const uint32_t *)(FLASH_ADDR + row_address);
+	uint32_t i;
+
+	for (i = 0; i < (NVMCTRL_ROW_PAGES * FLASH_PAGE_SIZE) / sizeof(uint32_t); i++) {
+		if (words[i] != 0xFFFFFFFF) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * \brief Erases the rows from start_row up to end_row (excluded) that are not
+ *        blank. Checking a row takes a fraction of its erase time, reading
+ *        the next row waits for the erase in flight. rows_erased counts the
+ *        erases queued, an erase that fails fails the call.
+ */
+enum status_code applet_erase_rows(uint32_t start_row, uint32_t end_row,
+		uint32_t *rows_erased)
+{
+	const uint32_t row_size = NVMCTRL_ROW_PAGES * FLASH_PAGE_SIZE;
+	enum status_code status = STATUS_OK;
+	uint32_t row;
+
+	*rows_erased = 0;
+	for (row = start_row; (row < end_row) && (status == STATUS_OK); row++) {
+		if (applet_row_is_blank(row * row_size)) {
+			continue;
+		}
+		while ((status = nvm_async_erase_row(row * row_size, NULL, NULL)) == STATUS_BUSY) {
+			nvm_async_poll();
+		}
+		if (status == STATUS_OK) {
+			(*rows_erased)++;
+		}
+	}
+	if (nvm_async_wait() != STATUS_OK) {
+		status = STATUS_ABORTED;
+	}
+	return status;
+}
+
+/**
+ * \brief Computes the CRC32 (IEEE 802.3, reflected, as zlib) of a word
+ *        aligned flash area. The DSU reads the whole words as a bus master
+ *        (applet_crc32_dsu()), the core adds the tail bytes, and the whole
+ *        area when the DSU refuses it.
+ */
+uint32_t applet_crc32(uint32_t address, uint32_t length)
+{
+	const uint8_t *flash = (const uint8_t *)(FLASH_ADDR + address);
+	uint32_t crc = 0xFFFFFFFF;
+	uint32_t i = 0;
+	uint8_t bit;
+
+	if ((length & ~3) && applet_crc32_dsu(address, length & ~3, &crc)) {
+		i = length & ~3;
+	}
+
+	for (; i < length; i++) {
+		crc ^= flash[i];
+		for (bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		}
+	}
+	return ~crc;
+}
+
+/**
+ * \brief Runs the entries of a batch in order and stops at the first one
+ *        that fails.
+ *
+ * \return Number of entries run, status holds the status of the last one
+ *         (APPLET_SUCCESS for an empty batch).
+ */
+uint32_t applet_batch_run(struct _BatchEntry *entry, uint32_t count,
+		applet_batch_callback command, uint32_t *status)
+{
+	uint32_t i;
+
+	*status = APPLET_SUCCESS;
+	for (i = 0; (i < count) && (*status == APPLET_SUCCESS); i++, entry++) {
+		command(entry);
+		*status = entry->status;
+	}
+	return i;
+}
@@ -0,0 +1,83 @@
+/**
+ * \file
+ *
+ * \brief Flash checks and row planning of the flash applet, free of peripheral
+ *        access so the host bench can run them against its flash model.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef FLASH_APP_OPS_H
+#define FLASH_APP_OPS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <status_codes.h>
+#include "nvm_async.h"
+
+/** Argument words of a batched command (APPLET_CMD_BATCH) */
+#define APPLET_BATCH_ARGUMENT_WORDS (6)
+
+/** One command of APPLET_CMD_BATCH, a mailbox with a shorter argument area.
+ *  The applet writes back the status and the output arguments. */
+struct _BatchEntry {
+
+    /** Command to execute.*/
+    uint32_t command;
+    /** Returned status.*/
+    uint32_t status;
+    /** Input and output arguments, as in the mailbox.*/
+    uint32_t argument[APPLET_BATCH_ARGUMENT_WORDS];
+};
+
+/** Runs one batched command and sets its status */
+typedef void (*applet_batch_callback)(struct _BatchEntry *entry);
+
+/** Result of applet_page_compare() */
+#define APPLET_PAGE_SAME	0	/* Flash already holds the data */
+#define APPLET_PAGE_PROGRAM	1	/* The data only clears bits */
+#define APPLET_PAGE_ERASE	2	/* The data sets bits, the row must be erased */
+
+uint8_t applet_page_compare(const uint32_t *flash, const uint32_t *data);
+bool applet_row_is_blank(uint32_t row_address);
+enum status_code applet_erase_rows(uint32_t start_row, uint32_t end_row,
+		uint32_t *rows_erased);
+uint32_t applet_crc32(uint32_t address, uint32_t length);
+bool applet_crc32_dsu(uint32_t address, uint32_t length, uint32_t *crc);
+uint32_t applet_batch_run(struct _BatchEntry *entry, uint32_t count,
+		applet_batch_callback command, uint32_t *status);
+enum status_code applet_row_queue(uint32_t row_start_address,
+		const uint8_t *row_buffer, nvm_async_callback callback, uint8_t *jobs);
+enum status_code applet_nvm_memcpy(const uint32_t destination_address,
+		uint8_t *const buffer, uint16_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,268 @@
+/**
+ * \file
+ *
+ * \brief Polled queue of NVM row erase and page write jobs.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <compiler.h>
+#include <nvm.h>
+#include "nvm_async.h"
+
+/*
+ * The ASF NVM driver waits for READY after every command. Here row erase and
+ * page write jobs are queued, and each one is started as soon as the previous
+ * one completes. The monitor calls the applet with PRIMASK set, so the
+ * queue advances from nvm_async_poll() and nvm_async_wait(), which also run
+ * the completion callbacks. Every job has completed when the applet returns.
+ *
+ * The core stalls on any flash access while the controller is busy, so only
+ * code running from SRAM (the applet) and DMA or USB transfers into SRAM make
+ * progress during a job.
+ *
+ * A job keeps a pointer to the caller's data, which must stay valid until its
+ * callback or nvm_async_wait(). Do not mix jobs with the blocking ASF nvm_*
+ * calls, drain the queue with nvm_async_wait() first.
+ */
+
+#if (NVM_ASYNC_QUEUE_LENGTH & (NVM_ASYNC_QUEUE_LENGTH - 1)) || (NVM_ASYNC_QUEUE_LENGTH > 128)
+#error NVM_ASYNC_QUEUE_LENGTH must be a power of two up to 128
+#endif
+
+#define NVM_ASYNC_ERASE             0
+#define NVM_ASYNC_WRITE             1
+
+typedef struct
+{
+	const uint8_t* buffer;
+	nvm_async_callback callback;
+	void* context;
+	uint32_t address;
+	uint16_t length;
+	uint8_t command;
+} nvm_async_job;
+
+static nvm_async_job nvm_async_queue[NVM_ASYNC_QUEUE_LENGTH];
+/** Job executing (when nvm_async_running) or to be started next */
+static uint8_t nvm_async_head;
+/** Next free slot */
+static uint8_t nvm_async_tail;
+static bool nvm_async_running;
+/** First failure since the last nvm_async_wait() */
+static enum status_code nvm_async_status;
+/** CTRLB before the cache was disabled for the jobs */
+static uint32_t nvm_async_ctrlb;
+static bool nvm_async_cache_disabled;
+
+/**
+ * \brief Issues a job to the controller, which must be ready
+ */
+static void nvm_async_start(const nvm_async_job* job)
+{
+	Nvmctrl *const nvm_module = NVMCTRL;
+	volatile uint16_t* page;
+	uint16_t data;
+	uint16_t i;
+
+	nvm_module->STATUS.reg = NVMCTRL_STATUS_MASK;
+
+	if (job->command == NVM_ASYNC_ERASE) {
+		nvm_module->ADDR.reg = job->address / 2;
+		nvm_module->CTRLA.reg = NVM_COMMAND_ERASE_ROW | NVMCTRL_CTRLA_CMDEX_KEY;
+	} else {
+		nvm_module->CTRLA.reg = NVM_COMMAND_PAGE_BUFFER_CLEAR | NVMCTRL_CTRLA_CMDEX_KEY;
+		while (!nvm_is_ready()) {
+			/* Clearing the page buffer takes a few cycles */
+		}
+		nvm_module->STATUS.reg = NVMCTRL_STATUS_MASK;
+
+		/* The page buffer only takes 16-bit writes */
+		page = (volatile uint16_t*)(FLASH_ADDR + job->address);
+		for (i = 0; i < job->length; i += 2) {
+			data = job->buffer[i];
+			if (i < (job->length - 1)) {
+				data |= (job->buffer[i + 1] << 8);
+			}
+			page[i / 2] = data;
+		}
+
+		/* Without MANW the last word of a full page starts the write */
+		if ((nvm_module->CTRLB.reg & NVMCTRL_CTRLB_MANW) || (job->length < NVMCTRL_PAGE_SIZE)) {
+			nvm_module->ADDR.reg = job->address / 2;
+			nvm_module->CTRLA.reg = NVM_COMMAND_WRITE_PAGE | NVMCTRL_CTRLA_CMDEX_KEY;
+		}
+	}
+}
+
+/**
+ * \brief Completes the job in flight if the controller is ready again and
+ *        starts the next one
+ */
+static void nvm_async_advance(void)
+{
+	Nvmctrl *const nvm_module = NVMCTRL;
+	const nvm_async_job* job;
+	enum status_code status;
+
+	if (nvm_async_running) {
+		if (!nvm_is_ready()) {
+			return;
+		}
+		status = (nvm_module->STATUS.reg & NVM_ERRORS_MASK) ? STATUS_ABORTED : STATUS_OK;
+		if ((status != STATUS_OK) && (nvm_async_status == STATUS_OK)) {
+			nvm_async_status = status;
+		}
+		job = &nvm_async_queue[nvm_async_head & (NVM_ASYNC_QUEUE_LENGTH - 1)];
+		nvm_async_running = false;
+		nvm_async_head++;
+		if (job->callback) {
+			job->callback(status, job->context);
+		}
+	}
+
+	if (nvm_async_head != nvm_async_tail) {
+		if (!nvm_async_running) {
+			nvm_async_running = true;
+			nvm_async_start(&nvm_async_queue[nvm_async_head & (NVM_ASYNC_QUEUE_LENGTH - 1)]);
+		}
+	} else if (nvm_async_cache_disabled) {
+		nvm_async_cache_disabled = false;
+		nvm_module->CTRLB.reg = nvm_async_ctrlb;
+	}
+}
+
+/**
+ * \brief Adds a job to the queue and starts it if the controller is idle
+ */
+static enum status_code nvm_async_submit(uint8_t command, uint32_t address,
+		const uint8_t* buffer, uint16_t length, nvm_async_callback callback, void* context)
+{
+	nvm_async_job* job;
+
+	if ((uint8_t)(nvm_async_tail - nvm_async_head) >= NVM_ASYNC_QUEUE_LENGTH) {
+		return STATUS_BUSY;
+	}
+
+	if (!nvm_async_cache_disabled) {
+		/* Like the ASF commands, keep the cache off while flash changes */
+		nvm_async_ctrlb = NVMCTRL->CTRLB.reg;
+		NVMCTRL->CTRLB.reg = nvm_async_ctrlb | NVMCTRL_CTRLB_CACHEDIS;
+		nvm_async_cache_disabled = true;
+	}
+
+	job = &nvm_async_queue[nvm_async_tail & (NVM_ASYNC_QUEUE_LENGTH - 1)];
+	job->command = command;
+	job->address = address;
+	job->buffer = buffer;
+	job->length = length;
+	job->callback = callback;
+	job->context = context;
+	nvm_async_tail++;
+
+	/* Starts the job right away if nothing is in flight */
+	nvm_async_advance();
+
+	return STATUS_OK;
+}
+
+/**
+ * \brief Clears the queue. Call while no ASF NVM command is running.
+ */
+void nvm_async_init(void)
+{
+	nvm_async_head = 0;
+	nvm_async_tail = 0;
+	nvm_async_running = false;
+	nvm_async_status = STATUS_OK;
+	/* CTRLB is the caller's again, even after an abandoned job */
+	nvm_async_cache_disabled = false;
+}
+
+/**
+ * \brief Queues the erase of a row
+ *
+ * \return STATUS_OK, STATUS_ERR_BAD_ADDRESS or STATUS_BUSY when the queue is full
+ */
+enum status_code nvm_async_erase_row(uint32_t row_address,
+		nvm_async_callback callback, void* context)
+{
+	if ((row_address >= FLASH_SIZE) || (row_address & ((NVMCTRL_ROW_PAGES * NVMCTRL_PAGE_SIZE) - 1))) {
+		return STATUS_ERR_BAD_ADDRESS;
+	}
+	return nvm_async_submit(NVM_ASYNC_ERASE, row_address, NULL, 0, callback, context);
+}
+
+/**
+ * \brief Queues the write of up to one page. buffer is read when the job
+ *        starts, it must stay valid until the job completes.
+ *
+ * \return STATUS_OK, STATUS_ERR_BAD_ADDRESS, STATUS_ERR_INVALID_ARG or
+ *         STATUS_BUSY when the queue is full
+ */
+enum status_code nvm_async_write_page(uint32_t page_address, const uint8_t* buffer,
+		uint16_t length, nvm_async_callback callback, void* context)
+{
+	if ((page_address >= FLASH_SIZE) || (page_address & (NVMCTRL_PAGE_SIZE - 1))) {
+		return STATUS_ERR_BAD_ADDRESS;
+	}
+	if ((length == 0) || (length > NVMCTRL_PAGE_SIZE)) {
+		return STATUS_ERR_INVALID_ARG;
+	}
+	return nvm_async_submit(NVM_ASYNC_WRITE, page_address, buffer, length, callback, context);
+}
+
+/**
+ * \brief Jobs queued or executing
+ */
+uint8_t nvm_async_pending(void)
+{
+	return (uint8_t)(nvm_async_tail - nvm_async_head);
+}
+
+/**
+ * \brief Advances the queue, completing the job in flight if it is done
+ */
+void nvm_async_poll(void)
+{
+	nvm_async_advance();
+}
+
+/**
+ * \brief Waits until every queued job has completed
+ *
+ * \return STATUS_OK, or STATUS_ABORTED if a job failed since the last wait
+ */
+enum status_code nvm_async_wait(void)
+{
+	enum status_code status;
+
+	while (nvm_async_pending()) {
+		nvm_async_poll();
+	}
+
+	status = nvm_async_status;
+	nvm_async_status = STATUS_OK;
+	return status;
+}
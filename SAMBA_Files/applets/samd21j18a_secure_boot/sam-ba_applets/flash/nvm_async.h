@@ -0,0 +1,63 @@
+/**
+ * \file
+ *
+ * \brief Polled queue of NVM row erase and page write jobs.
+ *
+ *
+ * \copyright (c) 2015-2019 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#ifndef NVM_ASYNC_H
+#define NVM_ASYNC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <status_codes.h>
+
+/** Jobs that can wait behind the one being executed, a power of two */
+#ifndef NVM_ASYNC_QUEUE_LENGTH
+#define NVM_ASYNC_QUEUE_LENGTH      8
+#endif
+
+/** \brief Called when a job completes, from nvm_async_poll() or
+ *         nvm_async_wait(). status is STATUS_OK or STATUS_ABORTED. */
+typedef void (*nvm_async_callback)(enum status_code status, void* context);
+
+void nvm_async_init(void);
+enum status_code nvm_async_erase_row(uint32_t row_address,
+		nvm_async_callback callback, void* context);
+enum status_code nvm_async_write_page(uint32_t page_address, const uint8_t* buffer,
+		uint16_t length, nvm_async_callback callback, void* context);
+uint8_t nvm_async_pending(void);
+void nvm_async_poll(void);
+enum status_code nvm_async_wait(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -111,6 +111,20 @@ array set appletCmdSamd21 {
     readLocks       0x42
     readFuses       0x43
     eraseApp        0x44
+    writeVerify     0x46
+    crc32           0x47
+    sha256          0x48
+    batch           0x49
+}
+
+# Features reported by the init command of the applet. An applet built
+# before a feature reports 0 for it and the script keeps the older path.
+array set appletFeatureSamd21 {
+    eraseCount      0x01
+    writeVerify     0x02
+    crc32           0x04
+    sha256          0x08
+    batch           0x10
 }
 
 set target(board) "samd21_secure_boot"
@@ -177,6 +191,14 @@ set FLASH::appletAddr             0x20002000
 set FLASH::appletMailboxAddr      0x20002040
 set FLASH::appletFileName         "$libPath(extLib)/$target(board)/applet-flash-samd21j18a.bin"
 
+#===============================================================================
+#  proc FLASH::HasFeature
+#===============================================================================
+# Returns 1 when the applet loaded reported the feature at init.
+proc FLASH::HasFeature { feature } {
+    return [expr ($::appletFeatures & $::appletFeatureSamd21($feature)) != 0]
+}
+
 # Initialize FLASH
 if {[catch {FLASH::Init} dummy_err]} { 
     if {$commandLineMode == 0} {
@@ -198,9 +220,12 @@ if {[catch {FLASH::Init} dummy_err]} {
         set flashNbPage         [TCL_Read_Int $target(handle) $appletAddrArgvnp]
         set flashAppStartPage     [TCL_Read_Int $target(handle) $appletAddrArgvasp]
 
+        set appletFeatures        [TCL_Read_Int $target(handle) [expr $FLASH::appletMailboxAddr + 0x24]]
+
         puts "flashPageSize     [format "0x%08x" $flashPageSize]"
         puts "flashNbPage         [format "%d" $flashNbPage]"
         puts "flashAppStartPage [format "%d" $flashAppStartPage]"
+        puts "appletFeatures    [format "0x%08x" $appletFeatures]"
         puts "-I- FLASH initialized"
 }
 
@@ -404,32 +429,108 @@ proc FLASH::UnlockAll { } {
     variable appletMailboxAddr
     set      dummy_err 0
 
-    # Mailbox is 32 word long (add variable here if you need read/write more data)
-    set appletAddrCmd       [expr $appletMailboxAddr]
-    set appletAddrStatus    [expr $appletMailboxAddr + 0x04]
-    set appletAddrArg_value [expr $appletMailboxAddr + 0x08]
+    if {![FLASH::HasFeature batch]} {
+        set appletAddrCmd       [expr $appletMailboxAddr]
+        set appletAddrArg_value [expr $appletMailboxAddr + 0x08]
+
+        # One applet run per region
+        for {set lockbit 0} {$lockbit < 16} {incr lockbit} {
+            if {[catch {TCL_Write_Int $target(handle) $::appletCmdSamd21(unlock) $appletAddrCmd} dummy_err] } {
+                error "Error Writing Applet command ($dummy_err)"
+            }
+            if {[catch {TCL_Write_Int $target(handle) [expr $lockbit] $appletAddrArg_value} dummy_err] } {
+                error "[format "0x%08x" $dummy_err]"
+            }
+            if {[catch {set result [GENERIC::Run $::appletCmdSamd21(unlock)]} dummy_err]} {
+                error "Applet lock command has not been launched ($dummy_err)"
+            }
+            puts "Region ($lockbit) unlocked"
+        }
+        return
+    }
 
-    set lockbit 0
-    while { $lockbit < [expr 16]} {
-        set writemask [expr 1 << $lockbit ]
+    # One applet run for the 16 regions
+    set commands {}
+    for {set lockbit 0} {$lockbit < 16} {incr lockbit} {
+        lappend commands [list $::appletCmdSamd21(unlock) $lockbit]
+    }
 
-        # Write the Cmd op code in the argument area
-        if {[catch {TCL_Write_Int $target(handle) $::appletCmdSamd21(unlock) $appletAddrCmd} dummy_err] } {
-            error "Error Writing Applet command ($dummy_err)"
-        }
-        # Write value in the argument area
-        if {[catch {TCL_Write_Int $target(handle) [expr $lockbit] $appletAddrArg_value} dummy_err] } {
-            error "[format "0x%08x" $dummy_err]"
+    set lockbit 0
+    foreach status [FLASH::Batch $commands] {
+        if {$status != 0} {
+            error "Region ($lockbit) unlock failed ([format "0x%08x" $status])"
         }
-        # Launch the applet Jumping to the appletAddr
-        if {[catch {set result [GENERIC::Run $::appletCmdSamd21(unlock)]} dummy_err]} {
-            error "Applet lock command has not been launched ($dummy_err)"
+        puts "Region ($lockbit) unlocked"
+        incr lockbit +1
+    }
+}
+
+#===============================================================================
+#  proc FLASH::Batch
+#===============================================================================
+# Runs a list of applet commands in one applet run. Each command is a list of
+# the command code and up to 6 argument words. The applet stops at the first
+# command that fails. Returns the status of each command run.
+proc FLASH::Batch { commands } {
+    global   target
+    variable appletMailboxAddr
+    set      dummy_err 0
+
+    set appletAddrCmd               [expr $appletMailboxAddr]
+    set appletAddrArg_buffer        [expr $appletMailboxAddr + 0x08]
+    set appletAddrArg_count         [expr $appletMailboxAddr + 0x0c]
+    # struct _BatchEntry: command, status and 6 argument words
+    set entrySize 32
+
+    if {![FLASH::HasFeature batch]} {
+        error "The flash applet has no batch command, rebuild applet-flash-samd21j18a.bin"
+    }
+
+    set count [llength $commands]
+    if {[expr $count * $entrySize] > $GENERIC::appletBufferSize} {
+        error "Too many commands for one batch ($count)"
+    }
+
+    set rawData ""
+    foreach command $commands {
+        set words [concat [lindex $command 0] 0xF [lrange $command 1 end]]
+        while {[llength $words] < [expr $entrySize / 4]} {
+            lappend words 0
         }
+        append rawData [binary format i* $words]
+    }
+    set size [string length $rawData]
 
-        puts "Region ($lockbit) unlocked"
+    if {[catch {TCL_Write_Data $target(handle) $GENERIC::appletBufferAddress rawData $size dummy_err} dummy_err] } {
+        error "Error writing batch ($dummy_err)"
+    }
+    if {[catch {TCL_Write_Int $target(handle) $::appletCmdSamd21(batch) $appletAddrCmd} dummy_err] } {
+        error "Error Writing Applet command ($dummy_err)"
+    }
+    if {[catch {TCL_Write_Int $target(handle) $GENERIC::appletBufferAddress $appletAddrArg_buffer} dummy_err] } {
+        error "[format "0x%08x" $dummy_err]"
+    }
+    if {[catch {TCL_Write_Int $target(handle) $count $appletAddrArg_count} dummy_err] } {
+        error "[format "0x%08x" $dummy_err]"
+    }
+    if {[catch {set result [GENERIC::Run $::appletCmdSamd21(batch)]} dummy_err]} {
+        error "Applet batch command has not been launched ($dummy_err)"
+    }
 
-        incr lockbit +1
+    # Statuses and outputs of all the entries come back in one read
+    if {[catch {set run [TCL_Read_Int $target(handle) $appletAddrArg_buffer]} dummy_err] } {
+        error "Error reading the number of commands run ($dummy_err)"
+    }
+    if {[catch {set rawData [TCL_Read_Data $target(handle) $GENERIC::appletBufferAddress [expr $run * $entrySize] dummy_err]} dummy_err] } {
+        error "Error reading batch ($dummy_err)"
     }
+    binary scan $rawData i* words
+
+    set statuses {}
+    for {set i 0} {$i < $run} {incr i} {
+        lappend statuses [expr [lindex $words [expr $i * $entrySize / 4 + 1]] & 0xFFFFFFFF]
+    }
+    return $statuses
 }
 
 #===============================================================================
@@ -502,7 +603,14 @@ proc FLASH::SendFileNoLock { name addr } {
         return -1
     }
 
-    if {[catch {GENERIC::Write $dest $size $f 0} dummy_err] } {
+    # The applet verifies flash on the target, there is no read back
+    if {[FLASH::HasFeature writeVerify]} {
+        if {[catch {FLASH::WriteVerify $dest $size $f} dummy_err] } {
+            puts "-E- FLASH::WriteVerify returned error ($dummy_err)"
+            close $f
+            return -1
+        }
+    } elseif {[catch {GENERIC::Write $dest $size $f 0} dummy_err] } {
         puts "-E- Generic::Write returned error ($dummy_err)"
         close $f
         return -1
@@ -510,6 +618,183 @@ proc FLASH::SendFileNoLock { name addr } {
     close $f
 }
 
+#===============================================================================
+#  proc FLASH::WriteVerify
+#===============================================================================
+# Writes a file through the applet buffer, the applet compares flash with the
+# buffer after programming and returns the offset of the first mismatch.
+proc FLASH::WriteVerify { dest size f } {
+    global   target
+    variable appletMailboxAddr
+    set      dummy_err 0
+
+    set appletAddrCmd               [expr $appletMailboxAddr]
+    set appletAddrArg_buffer        [expr $appletMailboxAddr + 0x08]
+    set appletAddrArg_size          [expr $appletMailboxAddr + 0x0c]
+    set appletAddrArg_offset        [expr $appletMailboxAddr + 0x10]
+    set appletAddrArg_mismatch      [expr $appletMailboxAddr + 0x0c]
+
+    while {$size > 0} {
+        set chunk $GENERIC::appletBufferSize
+        if {$chunk > $size} {
+            set chunk $size
+        }
+        set rawData [read $f $chunk]
+
+        if {[catch {TCL_Write_Data $target(handle) $GENERIC::appletBufferAddress rawData $chunk dummy_err} dummy_err] } {
+            error "Error writing applet buffer ($dummy_err)"
+        }
+        if {[catch {TCL_Write_Int $target(handle) $::appletCmdSamd21(writeVerify) $appletAddrCmd} dummy_err] } {
+            error "Error Writing Applet command ($dummy_err)"
+        }
+        if {[catch {TCL_Write_Int $target(handle) $GENERIC::appletBufferAddress $appletAddrArg_buffer} dummy_err] } {
+            error "[format "0x%08x" $dummy_err]"
+        }
+        if {[catch {TCL_Write_Int $target(handle) $chunk $appletAddrArg_size} dummy_err] } {
+            error "[format "0x%08x" $dummy_err]"
+        }
+        if {[catch {TCL_Write_Int $target(handle) $dest $appletAddrArg_offset} dummy_err] } {
+            error "[format "0x%08x" $dummy_err]"
+        }
+        if {[catch {set result [GENERIC::Run $::appletCmdSamd21(writeVerify)]} dummy_err]} {
+            error "Applet writeVerify command has not been launched ($dummy_err)"
+        }
+        if {$result != 0} {
+            if {[catch {set mismatch [TCL_Read_Int $target(handle) $appletAddrArg_mismatch]} dummy_err] } {
+                error "Error reading mismatch offset ($dummy_err)"
+            }
+            if {$mismatch != 0xFFFFFFFF} {
+                error "Flash differs at [format "0x%08x" $mismatch]"
+            }
+            error "Applet writeVerify command failed ([format "0x%08x" $result])"
+        }
+
+        set dest  [expr $dest + $chunk]
+        set size  [expr $size - $chunk]
+    }
+}
+
+#===============================================================================
+#  proc FLASH::CheckCrc
+#===============================================================================
+# Compares a file already in flash with its CRC32, one buffer at a time, with
+# no read back. The host CRC32 needs the zlib command of Tcl 8.6.
+proc FLASH::CheckCrc { name addr } {
+    global   target
+    variable appletMailboxAddr
+    variable flashSize
+    set      dummy_err 0
+
+    set appletAddrCmd               [expr $appletMailboxAddr]
+    set appletAddrArg_offset        [expr $appletMailboxAddr + 0x08]
+    set appletAddrArg_size          [expr $appletMailboxAddr + 0x0c]
+    set appletAddrArg_crc           [expr $appletMailboxAddr + 0x10]
+
+    if {![FLASH::HasFeature crc32]} {
+        error "The flash applet has no CRC32 command, rebuild applet-flash-samd21j18a.bin"
+    }
+    if {[llength [info commands zlib]] == 0} {
+        error "CRC32 check needs Tcl 8.6"
+    }
+    if { [catch {set f [open $name r]}] } {
+        error "Can't open file $name"
+    }
+    fconfigure $f -translation binary
+
+    set dest [expr $addr & [expr  $flashSize - 1]]
+    set size [file size $name]
+    while {$size > 0} {
+        # Nothing is transferred, a chunk only narrows down a mismatch
+        set chunk 0x1000
+        if {$chunk > $size} {
+            set chunk $size
+        }
+        set rawData [read $f $chunk]
+
+        if {[catch {TCL_Write_Int $target(handle) $::appletCmdSamd21(crc32) $appletAddrCmd} dummy_err] } {
+            close $f
+            error "Error Writing Applet command ($dummy_err)"
+        }
+        if {[catch {TCL_Write_Int $target(handle) $dest $appletAddrArg_offset} dummy_err] } {
+            close $f
+            error "[format "0x%08x" $dummy_err]"
+        }
+        if {[catch {TCL_Write_Int $target(handle) $chunk $appletAddrArg_size} dummy_err] } {
+            close $f
+            error "[format "0x%08x" $dummy_err]"
+        }
+        if {[catch {TCL_Write_Int $target(handle) [zlib crc32 $rawData] $appletAddrArg_crc} dummy_err] } {
+            close $f
+            error "[format "0x%08x" $dummy_err]"
+        }
+        if {[catch {set result [GENERIC::Run $::appletCmdSamd21(crc32)]} dummy_err]} {
+            close $f
+            error "Applet crc32 command has not been launched ($dummy_err)"
+        }
+        if {$result != 0} {
+            close $f
+            error "Flash differs from $name in [format "0x%08x" $dest] - [format "0x%08x" [expr $dest + $chunk - 1]]"
+        }
+
+        set dest  [expr $dest + $chunk]
+        set size  [expr $size - $chunk]
+    }
+    close $f
+    puts "-I- CRC32 of $name matches flash"
+}
+
+#===============================================================================
+#  proc FLASH::Sha256
+#===============================================================================
+# Returns the SHA-256 of a flash area as a hex string, computed by the applet
+# so the image can be signed as it is in flash without reading it back.
+proc FLASH::Sha256 { addr size } {
+    global   target
+    variable appletMailboxAddr
+    variable flashSize
+    set      dummy_err 0
+
+    set appletAddrCmd               [expr $appletMailboxAddr]
+    set appletAddrArg_buffer        [expr $appletMailboxAddr + 0x08]
+    set appletAddrArg_size          [expr $appletMailboxAddr + 0x0c]
+    set appletAddrArg_offset        [expr $appletMailboxAddr + 0x10]
+
+    if {![FLASH::HasFeature sha256]} {
+        error "The flash applet has no SHA-256 command, rebuild applet-flash-samd21j18a.bin"
+    }
+
+    if {[catch {TCL_Write_Int $target(handle) $::appletCmdSamd21(sha256) $appletAddrCmd} dummy_err] } {
+        error "Error Writing Applet command ($dummy_err)"
+    }
+    if {[catch {TCL_Write_Int $target(handle) $GENERIC::appletBufferAddress $appletAddrArg_buffer} dummy_err] } {
+        error "[format "0x%08x" $dummy_err]"
+    }
+    if {[catch {TCL_Write_Int $target(handle) $size $appletAddrArg_size} dummy_err] } {
+        error "[format "0x%08x" $dummy_err]"
+    }
+    if {[catch {TCL_Write_Int $target(handle) [expr $addr & [expr $flashSize - 1]] $appletAddrArg_offset} dummy_err] } {
+        error "[format "0x%08x" $dummy_err]"
+    }
+    if {[catch {set result [GENERIC::Run $::appletCmdSamd21(sha256)]} dummy_err]} {
+        error "Applet sha256 command has not been launched ($dummy_err)"
+    }
+    if {$result != 0} {
+        error "Applet sha256 command failed ([format "0x%08x" $result])"
+    }
+
+    # The digest is a byte string, each word is read least significant byte first
+    set digest ""
+    for {set i 0} {$i < 32} {incr i 4} {
+        if {[catch {set word [TCL_Read_Int $target(handle) [expr $GENERIC::appletBufferAddress + $i]]} dummy_err] } {
+            error "Error reading the digest ($dummy_err)"
+        }
+        for {set shift 0} {$shift < 32} {incr shift 8} {
+            append digest [format "%02x" [expr ($word >> $shift) & 0xff]]
+        }
+    }
+    return $digest
+}
+
 #===============================================================================
 #  proc FLASH::EraseRow
 #===============================================================================
@@ -583,5 +868,15 @@ proc FLASH::EraseApp { } {
         error "Applet eraseApp command has not been launched ($dummy_err)"
     }
 
-    puts "Application area erased"
+    if {![FLASH::HasFeature eraseCount]} {
+        puts "Application area erased"
+        return
+    }
+
+    # The applet skips blank rows and returns the number it erased
+    if {[catch {set erased [TCL_Read_Int $target(handle) $appletAddrArg_start_row]} dummy_err] } {
+        error "Error reading the number of rows erased ($dummy_err)"
+    }
+
+    puts "Application area erased ($erased of [expr $end - $start] rows were not blank)"
 }